@@ -0,0 +1,58 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <optional>
+
+#include "../src/constants.hpp"
+#include "../src/exchange.hpp"
+#include "../src/util/philox.hpp"
+#include "fixtures.hpp"
+
+namespace {
+using namespace leyval;
+using PRNG = Philox4x32;
+
+// Full Exchange::run() ticks, started over every constants::n_runs ticks as
+// main does, so the book stays near its starting depth. Args are the number
+// of agents, and the number of orders resting on each side at the start.
+void
+BM_ExchangeRun(benchmark::State& state)
+{
+  PRNG prng{ 7 };
+  const int num_agents{ static_cast<int>(state.range(0)) };
+  const int orders_per_side{ static_cast<int>(state.range(1)) };
+
+  // Holds a PRNG&, so is started over in place rather than assigned
+  std::optional<Exchange<PRNG>> exchange;
+  auto start_exchange = [&] {
+    exchange.emplace(bench::make_book(orders_per_side, num_agents, prng),
+                     bench::make_population(num_agents, prng),
+                     MatchingSystem<FifoMatching>{},
+                     prng);
+  };
+  start_exchange();
+  std::int64_t num_transactions{ 0 };
+
+  for (auto _ : state) {
+    if (exchange->get_tick() == constants::n_runs) [[unlikely]] {
+      state.PauseTiming();
+      num_transactions += exchange->get_stats().num_transactions;
+      start_exchange();
+      state.ResumeTiming();
+    }
+    exchange->run();
+  }
+  num_transactions += exchange->get_stats().num_transactions;
+  state.SetItemsProcessed(state.iterations());
+  state.counters["agents/s"] =
+    benchmark::Counter(static_cast<double>(num_agents),
+                       benchmark::Counter::kIsIterationInvariantRate);
+  state.counters["fills/s"] = benchmark::Counter(
+    static_cast<double>(num_transactions), benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_ExchangeRun)
+  ->ArgNames({ "agents", "orders" })
+  ->ArgsProduct({ { 170, 1'700, 17'000 }, { 50, 1'000, 20'000 } })
+  ->Unit(benchmark::kMicrosecond);
+}
@@ -0,0 +1,58 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+
+#include "../src/matching_system.hpp"
+#include "fixtures.hpp"
+
+namespace {
+using namespace leyval;
+using PRNG = std::mt19937;
+
+// Market buy orders against the asks of a book, refilled whenever it runs
+// short. Args are the number of orders resting on each side, and the volume of
+// each MarketOrderReq.
+template<MatchingPolicy Policy>
+void
+BM_MatchingSystem(benchmark::State& state)
+{
+  PRNG prng{ 5 };
+  const OrderBook base{ bench::make_book(
+    static_cast<int>(state.range(0)), 170, prng) };
+  const int volume{ static_cast<int>(state.range(1)) };
+  OrderBook order_book{ base };
+  MatchingSystem<Policy> matching_sys{ Policy{} };
+  std::int64_t num_fills{ 0 };
+
+  for (auto _ : state) {
+    if (order_book.get_state().volume_ask < volume) [[unlikely]] {
+      state.PauseTiming();
+      order_book = base;
+      state.ResumeTiming();
+    }
+    const auto& trans_reqs{ matching_sys(
+      { .volume = volume, .agent_id = 0, .order_dir = OrderDir::Bid },
+      order_book) };
+    num_fills += static_cast<std::int64_t>(trans_reqs.size());
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["fills"] = benchmark::Counter(
+    static_cast<double>(num_fills), benchmark::Counter::kIsRate);
+}
+
+void
+matching_args(benchmark::internal::Benchmark* bench)
+{
+  bench->ArgNames({ "orders", "volume" });
+  for (const int orders : { 256, 4'096, 65'536 }) {
+    for (const int volume : { 1, 16, 256 }) {
+      bench->Args({ orders, volume });
+    }
+  }
+}
+
+BENCHMARK(BM_MatchingSystem<FifoMatching>)->Apply(matching_args);
+BENCHMARK(BM_MatchingSystem<ProRataMatching>)->Apply(matching_args);
+BENCHMARK(BM_MatchingSystem<RandomSelectionMatching>)->Apply(matching_args);
+}
@@ -0,0 +1,113 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "../src/order_book.hpp"
+#include "fixtures.hpp"
+
+namespace {
+using namespace leyval;
+using PRNG = std::mt19937;
+
+constexpr int batch_size{ 1'024 };
+constexpr int num_agents{ 170 };
+
+// Arg is the number of orders resting on each side beforehand
+void
+BM_OrderBookInsert(benchmark::State& state)
+{
+  PRNG prng{ 1 };
+  const OrderBook base{ bench::make_book(
+    static_cast<int>(state.range(0)), num_agents, prng) };
+  // Drawn up front, so only insert() is timed
+  const OrderBook source{ bench::make_book(batch_size, num_agents, prng) };
+  std::vector<LimitOrderReq> reqs;
+  for (const OrderDir dir : { OrderDir::Bid, OrderDir::Ask }) {
+    source.for_each_level(dir, [&](Money price, const auto& level) {
+      reqs.insert(reqs.end(),
+                  level.size(),
+                  { .volume = 1, .price = price, .order_dir = dir });
+    });
+  }
+  std::ranges::shuffle(reqs, prng);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    OrderBook order_book{ base };
+    order_book.reserve(base.get_state().num_orders_bid + reqs.size());
+    state.ResumeTiming();
+    for (const LimitOrderReq& lor : reqs) {
+      benchmark::DoNotOptimize(order_book.insert(lor));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(reqs.size()));
+}
+BENCHMARK(BM_OrderBookInsert)->RangeMultiplier(8)->Range(64, 32'768);
+
+// Empties the bid side an agent at a time. Arg is the number of orders resting
+// on each side beforehand.
+void
+BM_OrderBookRemoveEarliest(benchmark::State& state)
+{
+  PRNG prng{ 2 };
+  const OrderBook base{ bench::make_book(
+    static_cast<int>(state.range(0)), num_agents, prng) };
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    OrderBook order_book{ base };
+    state.ResumeTiming();
+    for (int agent_id{ 0 }; agent_id < num_agents; ++agent_id) {
+      while (order_book.remove_earliest_order(agent_id, OrderDir::Bid)) {
+      }
+    }
+    benchmark::DoNotOptimize(order_book.get_state());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_OrderBookRemoveEarliest)->RangeMultiplier(8)->Range(64, 32'768);
+
+// OrderBook::State is brought up to date on every change, so this times that,
+// through the smallest change there is: a 1 share fill at the best bid, then
+// reading the State. Arg is the number of orders resting on each side.
+void
+BM_OrderBookUpdateGetState(benchmark::State& state)
+{
+  PRNG prng{ 3 };
+  const OrderBook base{ bench::make_book(
+    static_cast<int>(state.range(0)), num_agents, prng) };
+  OrderBook order_book{ base };
+
+  for (auto _ : state) {
+    if (order_book.empty(OrderDir::Bid)) [[unlikely]] {
+      state.PauseTiming();
+      order_book = base;
+      state.ResumeTiming();
+    }
+    order_book.fill_order(
+      order_book.orders_at_best_price(OrderDir::Bid).first, OrderDir::Bid, 1);
+    benchmark::DoNotOptimize(order_book.get_state());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OrderBookUpdateGetState)->RangeMultiplier(8)->Range(64, 32'768);
+
+// Best 10 levels of each side, as a depth histogram
+void
+BM_OrderBookDepth(benchmark::State& state)
+{
+  PRNG prng{ 4 };
+  const OrderBook order_book{ bench::make_book(
+    static_cast<int>(state.range(0)), num_agents, prng) };
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(order_book.depth<10>());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OrderBookDepth)->RangeMultiplier(8)->Range(64, 32'768);
+}
@@ -0,0 +1,50 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "../src/population.hpp"
+#include "../src/util/philox.hpp"
+#include "fixtures.hpp"
+
+namespace {
+using namespace leyval;
+using PRNG = Philox4x32;
+
+// One tick of decisions by Arg agents, all of Type
+template<AgentType Type>
+void
+BM_GenerateOrders(benchmark::State& state)
+{
+  PRNG prng{ 6 };
+  const OrderBook::State ob_state{
+    bench::make_book(1'000, 170, prng).get_state()
+  };
+  Population<PRNG> agents{};
+  const int num_agents{ static_cast<int>(state.range(0)) };
+  agents.reserve(num_agents);
+  for (int i{ 0 }; i < num_agents; ++i) {
+    agents.add(Type, 100'000, prng);
+  }
+  std::vector<int> ids(num_agents);
+  std::iota(ids.begin(), ids.end(), 0);
+  std::vector<OrderReq_t> reqs;
+  reqs.reserve(2 * ids.size());
+
+  std::uint32_t tick{ 0 };
+  for (auto _ : state) {
+    reqs.clear();
+    agents.generate_orders(ob_state, ++tick, ids, reqs);
+    benchmark::DoNotOptimize(reqs.data());
+  }
+  state.SetItemsProcessed(state.iterations() * num_agents);
+}
+
+BENCHMARK(BM_GenerateOrders<AgentType::jf_provider>)
+  ->RangeMultiplier(8)
+  ->Range(64, 262'144);
+BENCHMARK(BM_GenerateOrders<AgentType::jf_taker>)
+  ->RangeMultiplier(8)
+  ->Range(64, 262'144);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <random>
+
+#include "../src/constants.hpp"
+#include "../src/order_book.hpp"
+#include "../src/population.hpp"
+
+namespace leyval::bench {
+// Book with orders_per_side resting on each side, priced like
+// Exchange::saturate(), and owned by agents [0, num_agents)
+template<class PRNG>
+OrderBook
+make_book(int orders_per_side, int num_agents, PRNG& prng)
+{
+  using namespace constants::saturate;
+  std::uniform_int_distribution<> agent_id(0, num_agents - 1);
+  std::uniform_int_distribution<> bid_prices(price_center - price_far_offset,
+                                             price_center - price_close_offset);
+  std::uniform_int_distribution<> ask_prices(price_center + price_close_offset,
+                                             price_center + price_far_offset);
+  std::poisson_distribution<> volume(4);
+
+  OrderBook order_book{};
+  order_book.reserve(orders_per_side);
+  for (int i{ 0 }; i < orders_per_side; ++i) {
+    order_book.insert({ .volume = 1 + volume(prng),
+                        .agent_id = agent_id(prng),
+                        .price = bid_prices(prng),
+                        .order_dir = OrderDir::Bid });
+    order_book.insert({ .volume = 1 + volume(prng),
+                        .agent_id = agent_id(prng),
+                        .price = ask_prices(prng),
+                        .order_dir = OrderDir::Ask });
+  }
+  return order_book;
+}
+
+// num_agents split between providers and takers in the ratio of
+// make_jf_agents()
+template<class PRNG>
+Population<PRNG>
+make_population(int num_agents, PRNG& prng)
+{
+  const int num_providers{ num_agents * constants::n_providers /
+                           (constants::n_providers + constants::n_takers) };
+  Population<PRNG> agents{};
+  agents.reserve(num_agents);
+  for (int i{ 0 }; i < num_agents; ++i) {
+    agents.add(i < num_providers ? AgentType::jf_provider
+                                 : AgentType::jf_taker,
+               100'000,
+               prng);
+  }
+  agents.shuffle(prng);
+  return agents;
+}
+}
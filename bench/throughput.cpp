@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "../src/my_spdlog.hpp"
+
+#include "../src/constants.hpp"
+#include "../src/exchange.hpp"
+#include "../src/matching_system.hpp"
+#include "../src/util/philox.hpp"
+#include "fixtures.hpp"
+
+// Usage: throughput [FIFO|Pro_Rata|RSS] [num_ticks]
+// Runs Exchange::run() for num_ticks at every setting of the sweep below, and
+// writes one CSV row per setting to data/throughput.csv, for
+// scripts/throughput.py to plot.
+namespace {
+using namespace leyval;
+using PRNG = Philox4x32;
+using Clock = std::chrono::steady_clock;
+
+struct Setting
+{
+  int num_agents;
+  int orders_per_side;
+  double mean_market_volume;
+  std::size_t num_threads;
+};
+
+struct Result
+{
+  double ticks_per_sec;
+  double orders_per_sec;
+  double fills_per_sec;
+  double p50_tick_us;
+  double p99_tick_us;
+  long peak_rss_kib;
+};
+
+// Peak resident set size since the last reset_peak_rss(), in KiB
+long
+peak_rss_kib()
+{
+  std::ifstream status{ "/proc/self/status" };
+  for (std::string line; std::getline(status, line);) {
+    if (line.starts_with("VmHWM:")) {
+      return std::stol(line.substr(6));
+    }
+  }
+  // Without procfs, the peak over the whole process
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+// Only on Linux. Elsewhere peaks carry over from earlier settings, which the
+// sweep runs from smallest to largest to keep meaningful.
+void
+reset_peak_rss()
+{
+  std::ofstream clear_refs{ "/proc/self/clear_refs" };
+  clear_refs << "5";
+}
+
+double
+percentile(std::vector<double>& samples, double p)
+{
+  const auto nth{ samples.begin() +
+                  static_cast<std::ptrdiff_t>(p * (samples.size() - 1)) };
+  std::ranges::nth_element(samples, nth);
+  return *nth;
+}
+
+Result
+measure(const MatchingConfig& matching_config,
+        const Setting& setting,
+        int num_ticks)
+{
+  reset_peak_rss();
+  PRNG prng{ 1 };
+  Population<PRNG> agents{ bench::make_population(setting.num_agents,
+                                                  prng) };
+  agents.set_mean_market_volume(setting.mean_market_volume);
+  AnyExchange<PRNG> any_exch{ make_exchange(
+    matching_config,
+    bench::make_book(setting.orders_per_side, setting.num_agents, prng),
+    std::move(agents),
+    prng) };
+
+  return std::visit(
+    [&](auto& exch) {
+      exch.set_num_threads(setting.num_threads);
+      std::vector<double> tick_us;
+      tick_us.reserve(num_ticks);
+
+      const auto start{ Clock::now() };
+      for (int tick{ 0 }; tick < num_ticks; ++tick) {
+        const auto tick_start{ Clock::now() };
+        exch.run();
+        tick_us.push_back(std::chrono::duration<double, std::micro>(
+                            Clock::now() - tick_start)
+                            .count());
+      }
+      const double secs{
+        std::chrono::duration<double>(Clock::now() - start).count()
+      };
+
+      const auto& stats{ exch.get_stats() };
+      return Result{
+        .ticks_per_sec = num_ticks / secs,
+        .orders_per_sec = static_cast<double>(stats.num_order_requests) / secs,
+        .fills_per_sec = stats.num_transactions / secs,
+        .p50_tick_us = percentile(tick_us, 0.5),
+        .p99_tick_us = percentile(tick_us, 0.99),
+        .peak_rss_kib = peak_rss_kib(),
+      };
+    },
+    any_exch);
+}
+}
+
+int
+main(int argc, char* argv[])
+{
+  spdlog::set_pattern("[%C%m%d %T.%e] [%^%-8l%$] [%s:%# (%!)] %v");
+  spdlog::set_level(spdlog::level::info);
+
+  MatchingConfig matching_config{};
+  if (argc > 1) {
+    matching_config.type = matching_type_from_string(argv[1]);
+  }
+  const int num_ticks{ argc > 2 ? std::stoi(argv[2]) : constants::n_runs };
+
+  std::vector<std::size_t> thread_counts{ 1 };
+  const std::size_t max_threads{ std::max(
+    1U, std::thread::hardware_concurrency()) };
+  for (std::size_t n{ 2 }; n < max_threads; n *= 2) {
+    thread_counts.push_back(n);
+  }
+  if (max_threads > 1) {
+    thread_counts.push_back(max_threads);
+  }
+
+  std::filesystem::create_directory(constants::data_dir);
+  std::ofstream out_file{ constants::data_dir / "throughput.csv" };
+  out_file << "matching,num_agents,orders_per_side,mean_market_volume,"
+              "num_threads,num_ticks,ticks_per_sec,orders_per_sec,"
+              "fills_per_sec,p50_tick_us,p99_tick_us,peak_rss_kib\n";
+
+  for (const int num_agents : { 170, 1'700, 17'000 }) {
+    for (const int orders_per_side : { 50, 1'000, 20'000 }) {
+      for (const double mean_market_volume : { 2.0, 16.0, 128.0 }) {
+        for (const std::size_t num_threads : thread_counts) {
+          const Setting setting{ num_agents,
+                                 orders_per_side,
+                                 mean_market_volume,
+                                 num_threads };
+          Result result{};
+          try {
+            result = measure(matching_config, setting, num_ticks);
+          } catch (const std::domain_error& e) {
+            // Market orders large enough to empty a thin book can leave
+            // providers quoting prices the book's grid does not hold
+            SPDLOG_WARN("agents: {}, orders: {}, MO volume: {}, threads: {}: "
+                        "skipped, model broke down: {}",
+                        num_agents,
+                        orders_per_side,
+                        mean_market_volume,
+                        num_threads,
+                        e.what());
+            continue;
+          }
+          SPDLOG_INFO("agents: {}, orders: {}, MO volume: {}, threads: {}: "
+                      "{:.0f} ticks/s, p99 {:.0f} us",
+                      num_agents,
+                      orders_per_side,
+                      mean_market_volume,
+                      num_threads,
+                      result.ticks_per_sec,
+                      result.p99_tick_us);
+          out_file << fmt::format(
+            "{},{},{},{},{},{},{},{},{},{},{},{}\n",
+            matching_type_name(matching_config.type),
+            num_agents,
+            orders_per_side,
+            mean_market_volume,
+            num_threads,
+            num_ticks,
+            result.ticks_per_sec,
+            result.orders_per_sec,
+            result.fills_per_sec,
+            result.p50_tick_us,
+            result.p99_tick_us,
+            result.peak_rss_kib);
+        }
+      }
+    }
+  }
+  SPDLOG_INFO("THROUGHPUT FINISHED");
+  return 0;
+}
@@ -19,5 +19,6 @@ stdenv.mkDerivation {
     fmt
     nlohmann_json
     catch2_3
+    gbenchmark
   ];
 }
@@ -0,0 +1,56 @@
+"""Reader for the event log written by leyval::EventLogWriter.
+
+See src/event_log.hpp for the layout. Columns are numpy views into the
+memory-mapped file, so nothing is copied until it is used. A truncated last
+block, as left by a crashed run, is skipped.
+"""
+import numpy as np
+
+MAGIC = b"LEYVALEV"
+VERSION = 2
+NO_ORDER_ID = np.iinfo(np.uint64).max
+
+# timestamp is the logical Timestamp, tick << 32 | seq
+LIMIT_ORDER, MARKET_ORDER, CANCEL_ORDER, FILL = range(4)
+BID, ASK = range(2)
+
+# In file order
+COLUMNS = [('timestamp', '<i8'), ('price', '<i8'), ('order_id', '<u8'),
+           ('agent_id', '<i4'), ('volume', '<i4'), ('type', 'u1'),
+           ('direction', 'u1')]
+_FILE_HEADER_SIZE = 16
+_BLOCK_HEADER_SIZE = 8
+
+
+def read_blocks(path):
+    """Yields a dict of column name to array view, per block."""
+    data = np.memmap(path, dtype='u1', mode='r')
+    if data[:8].tobytes() != MAGIC:
+        raise ValueError(f"{path} is not an event log")
+    if data[8:12].view('<u4')[0] != VERSION:
+        raise ValueError(f"{path} has unsupported version")
+
+    pos = _FILE_HEADER_SIZE
+    while len(data) - pos >= _BLOCK_HEADER_SIZE:
+        n = int(data[pos:pos + 4].view('<u4')[0])
+        size = _BLOCK_HEADER_SIZE + sum(n * np.dtype(t).itemsize
+                                        for _, t in COLUMNS)
+        size += -size % 8
+        if n == 0 or len(data) - pos < size:
+            return
+
+        offset = pos + _BLOCK_HEADER_SIZE
+        block = {}
+        for name, dtype in COLUMNS:
+            nbytes = n * np.dtype(dtype).itemsize
+            block[name] = data[offset:offset + nbytes].view(dtype)
+            offset += nbytes
+        yield block
+        pos += size
+
+
+def read_columns(path):
+    """Every block joined into one dict of column name to array."""
+    blocks = list(read_blocks(path))
+    return {name: np.concatenate([b[name] for b in blocks])
+            for name, _ in COLUMNS}
@@ -1,11 +1,11 @@
-import json
-
 import pandas as pd
 import matplotlib.pyplot as plt
 import numpy as np
 import matplotlib.animation as animation
 
-DATA_FILE = "../data/pretty.json"
+from snapshot import SnapshotReader
+
+DATA_FILE = "../data/snapshots.bin"
 IMG_DIR = "img/"
 
 FIGSIZE = (8, 4.5)
@@ -20,27 +20,24 @@ class LeyvalPlotter:
         self.book_clean: pd.DataFrame
 
     @staticmethod
-    def _read_agents(agents_json):
-        return pd.json_normalize(agents_json)
+    def _read_agents(reader, capital, shares):
+        return pd.DataFrame({'id': reader.agent_ids,
+                             'capital': capital,
+                             'shares': shares,
+                             'type': reader.agent_types})
 
     @staticmethod
-    def _read_book(book_json):
-        bids = pd.Series([x[1] for x in book_json['bid_counts']],
-                         index = [x[0][0] for x in book_json['bid_counts']],
-                         name='bids')
-        asks = pd.Series([x[1] for x in book_json['ask_counts']],
-                         index = [x[0][0] for x in book_json['ask_counts']],
-                         name='asks')
+    def _read_book(bid_levels, ask_levels):
+        bids = pd.Series(bid_levels[1], index=bid_levels[0], name='bids')
+        asks = pd.Series(ask_levels[1], index=ask_levels[0], name='asks')
         return pd.concat([bids, asks], keys=['bids', 'asks'])
 
     # TODO: Split read_raw and clean_data for agents/book
     def read_raw(self):
-        with open(self.data_file, 'r') as f:
-            raw_json = json.load(f)
-
-        for run_tick in raw_json:
-            self._agents_raw.append(self._read_agents(run_tick['agents']))
-            self._book_raw.append(self._read_book(run_tick['order_book']))
+        reader = SnapshotReader(self.data_file)
+        for _, capital, shares, bids, asks in reader:
+            self._agents_raw.append(self._read_agents(reader, capital, shares))
+            self._book_raw.append(self._read_book(bids, asks))
         print("RAW DATA READ")
 
     def clean_data(self):
@@ -0,0 +1,69 @@
+"""Reader for the binary snapshot stream written by leyval::SnapshotWriter.
+
+See src/snapshot.hpp for the layout. A truncated last record, as left by a
+crashed run, is skipped.
+"""
+import struct
+
+import numpy as np
+
+MAGIC = b"LEYVALSS"
+VERSION = 1
+
+
+class SnapshotReader:
+    def __init__(self, path):
+        self.path = path
+        with open(path, 'rb') as f:
+            self._data = f.read()
+        self._pos = 0
+
+        if self._take(len(MAGIC)) != MAGIC:
+            raise ValueError(f"{path} is not a snapshot stream")
+        version, n_agents = self._unpack('<II')
+        if version != VERSION:
+            raise ValueError(f"{path} has unsupported version {version}")
+
+        self.agent_ids = []
+        self.agent_types = []
+        for _ in range(n_agents):
+            agent_id, type_len = self._unpack('<iH')
+            self.agent_ids.append(agent_id)
+            self.agent_types.append(self._take(type_len).decode())
+
+    def _take(self, n):
+        chunk = self._data[self._pos:self._pos + n]
+        self._pos += n
+        return chunk
+
+    def _unpack(self, fmt):
+        return struct.unpack(fmt, self._take(struct.calcsize(fmt)))
+
+    def _column(self, dtype, n):
+        column = np.frombuffer(self._data, dtype=dtype, count=n,
+                               offset=self._pos)
+        self._pos += column.nbytes
+        return column
+
+    def _levels(self):
+        (n,) = self._unpack('<I')
+        prices = self._column('<i8', n)
+        num_orders = self._column('<i4', n)
+        return prices, num_orders
+
+    def __iter__(self):
+        """Yields (tick, capital, shares, (bid_prices, bid_counts),
+        (ask_prices, ask_counts)), with agent columns in header order."""
+        n_agents = len(self.agent_ids)
+        while self._pos + 4 <= len(self._data):
+            (payload_len,) = self._unpack('<I')
+            end = self._pos + payload_len
+            if end > len(self._data):
+                return
+            (tick,) = self._unpack('<I')
+            capital = self._column('<i8', n_agents)
+            shares = self._column('<i4', n_agents)
+            bids = self._levels()
+            asks = self._levels()
+            self._pos = end
+            yield tick, capital, shares, bids, asks
@@ -0,0 +1,42 @@
+import pandas as pd
+import matplotlib.pyplot as plt
+
+# Written by build/release/throughput, run from the repo root
+DATA_FILE = "../data/throughput.csv"
+IMG_DIR = "img/"
+
+FIGSIZE = (12, 4.5)
+DPI = 200
+
+# One row per setting of the sweep
+throughput = pd.read_csv(DATA_FILE)
+matching = ", ".join(throughput['matching'].unique())
+
+
+def plot_scaling(column, ylabel, file_name):
+    """column against num_agents, one panel per mean_market_volume, one line
+    per (orders_per_side, num_threads)"""
+    volumes = sorted(throughput['mean_market_volume'].unique())
+    fig, axs = plt.subplots(1, len(volumes), figsize=FIGSIZE, dpi=DPI,
+                            layout='constrained', sharey=True, squeeze=False)
+    for ax, volume in zip(axs[0], volumes):
+        at_volume = throughput[throughput['mean_market_volume'] == volume]
+        for (orders, threads), curve in at_volume.groupby(['orders_per_side',
+                                                           'num_threads']):
+            curve = curve.sort_values('num_agents')
+            ax.plot(curve['num_agents'], curve[column], marker='o',
+                    label=f"{orders} orders, {threads} threads")
+        ax.set(xscale='log', yscale='log', xlabel='Agents',
+               title=f"Mean MO volume {volume:g}")
+    axs[0][0].set(ylabel=ylabel)
+    axs[0][-1].legend(fontsize='small')
+    fig.suptitle(f"{ylabel} ({matching})")
+    plt.savefig(IMG_DIR + file_name)
+
+
+plot_scaling('ticks_per_sec', 'Ticks/s', "throughput_ticks.png")
+plot_scaling('orders_per_sec', 'Orders/s', "throughput_orders.png")
+plot_scaling('fills_per_sec', 'Fills/s', "throughput_fills.png")
+plot_scaling('p99_tick_us', 'p99 tick (us)', "throughput_p99.png")
+plot_scaling('peak_rss_kib', 'Peak RSS (KiB)', "throughput_rss.png")
+print("THROUGHPUT PLOTS SAVED")
@@ -1,7 +1,16 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <random>
+#include <ranges>
+#include <vector>
 
+#include "my_spdlog.hpp"
 #include "serializable.hpp"
 
 #include "constants.hpp"
@@ -11,12 +20,45 @@
 #include "util/truncated_distribution.hpp"
 
 namespace leyval {
+// Seeds a new stream from prng.
+// Each agent draws from its own stream, so its draws do not depend on when
+// other agents draw, e.g. when deciding in parallel.
+// Counter-based engines (Philox4x32) keep prng's key, under a stream id drawn
+// from it, which is far cheaper than seeding a new engine.
+template<class PRNG>
+PRNG
+split_stream(PRNG& prng)
+{
+  if constexpr (requires { prng.split(std::uint64_t{}); }) {
+    const std::uint64_t stream{ std::uint64_t{ prng() } << 32 | prng() };
+    return prng.split(stream);
+  } else {
+    std::seed_seq seq{ prng(), prng(), prng(), prng() };
+    return PRNG{ seq };
+  }
+}
+
+// Moves prng to where its draws for tick start, for engines that can seek
+// (Philox4x32), so that they depend only on the stream and the tick, not on
+// how much was drawn in earlier ticks. Each tick has 2^32 blocks of room.
+// Other engines carry on from where the last tick left off.
+template<class PRNG>
+void
+seek_tick(PRNG& prng, std::uint32_t tick)
+{
+  if constexpr (requires { prng.seek(std::uint64_t{}); }) {
+    prng.seek(std::uint64_t{ tick } << 32);
+  }
+}
+
+// One object per agent, for models still being prototyped, such as the
+// Jericevich agents below. Exchange runs a Population (population.hpp).
 template<class PRNG>
 class Agent
 {
 public:
   Agent(Money capital, std::string type, PRNG& prng)
-    : m_prng{ prng }
+    : m_prng{ split_stream(prng) }
     , m_id{ new_id() }
     , m_capital{ capital }
     , m_shares{ 0 }
@@ -27,17 +69,26 @@ public:
   virtual ~Agent() = default;
 
   // generate instance of variant: https://stackoverflow.com/a/74303228
-  // NOTE: empty vector means agent is choosing to noop
-  [[nodiscard]] virtual std::vector<OrderReq_t> generate_order(
-    const OrderBook::State& ob_state) const = 0;
+  // Appends this tick's requests to reqs. Appending none means agent is
+  // choosing to noop.
+  // reqs belongs to the Exchange and is reused every tick, so once it has
+  // grown, deciding does not allocate.
+  virtual void generate_order(const OrderBook::State& ob_state,
+                              std::vector<OrderReq_t>& reqs) const = 0;
 
   void buy(const int volume, const Money total_price);
   void sell(const int volume, const Money total_price);
 
   [[nodiscard]] virtual int get_id() const { return m_id; }
+  [[nodiscard]] Money get_capital() const { return m_capital; }
+  [[nodiscard]] int get_shares() const { return m_shares; }
+  [[nodiscard]] const std::string& get_type() const { return m_type; }
+  void set_id(int id) { m_id = id; }
 
 protected:
-  PRNG& m_prng;
+  // generate_order only draws from here, so it is safe to call concurrently
+  // on different agents
+  mutable PRNG m_prng;
 
 private:
   int m_id{};
@@ -45,9 +96,10 @@ private:
   int m_shares{};
   std::string m_type{};
 
+  // Agents may be built concurrently, e.g. for independent Exchanges
   static int new_id()
   {
-    static int id{ -1 };
+    static std::atomic<int> id{ -1 };
     return ++id;
   }
 
@@ -119,7 +171,7 @@ power_law_distribution(float x_m, float alpha, PRNG& prng)
   return -x_m / (std::pow(x, 1.0 / alpha));
 }
 
-double
+inline double
 calc_alpha(const OrderBook::State& ob_state, const OrderDir od)
 {
   // TODO: Check MOR direction (sell MO is minus)
@@ -138,7 +190,7 @@ protected:
                        float lambda_min,
                        float lambda_val,
                        float lambda_max)
-    : Agent_JericevichBase<PRNG>{ capital, type, prng }
+    : Agent<PRNG>{ capital, type, prng }
     , m_lambda_min{ lambda_min }
     , m_lambda_val{ lambda_val }
     , m_lambda_max{ lambda_max }
@@ -156,9 +208,19 @@ private:
   trunc_exp_dist m_arrival_dist;
 
 protected:
-  Timer m_timer{ [&]() {
-    return static_cast<Timer::num_t>(arrival_dist(this->m_prng));
-  } };
+  // Draws the ticks until the agent next acts, at least 1.
+  // Points back at its agent, so agents must not be copied.
+  struct NextArrival
+  {
+    Agent_JericevichBase* agent;
+    unsigned int operator()() const
+    {
+      return static_cast<unsigned int>(agent->m_arrival_dist(
+        agent->m_prng, 1, std::numeric_limits<float>::infinity()));
+    }
+  };
+  // Ticked from the const generate_order
+  mutable Timer<NextArrival> m_timer{ NextArrival{ this } };
 };
 
 template<class PRNG>
@@ -176,8 +238,8 @@ public:
     }
   {
   }
-  [[nodiscard]] std::vector<OrderReq_t> generate_order(
-    const OrderBook::State& ob_state) const override;
+  void generate_order(const OrderBook::State& ob_state,
+                      std::vector<OrderReq_t>& reqs) const override;
 
 private:
   double m_fundamental_value;
@@ -215,8 +277,8 @@ public:
     }
   {
   }
-  [[nodiscard]] std::vector<OrderReq_t> generate_order(
-    const OrderBook::State& ob_state) const override;
+  void generate_order(const OrderBook::State& ob_state,
+                      std::vector<OrderReq_t>& reqs) const override;
 
 private:
   double m_ema;
@@ -253,32 +315,8 @@ public:
     }
   {
   }
-  [[nodiscard]] std::vector<OrderReq_t> generate_order(
-    const OrderBook::State& ob_state) const override;
-};
-
-template<class PRNG>
-class Agent_JFProvider : public Agent<PRNG>
-{
-public:
-  Agent_JFProvider(Money capital, PRNG& prng)
-    : Agent<PRNG>{ capital, "JFProvider", prng }
-  {
-  }
-  [[nodiscard]] std::vector<OrderReq_t> generate_order(
-    const OrderBook::State& ob_state) const override;
-};
-
-template<class PRNG>
-class Agent_JFTaker : public Agent<PRNG>
-{
-public:
-  Agent_JFTaker(Money capital, PRNG& prng)
-    : Agent<PRNG>{ capital, "JFTaker", prng }
-  {
-  }
-  [[nodiscard]] std::vector<OrderReq_t> generate_order(
-    const OrderBook::State& ob_state) const override;
+  void generate_order(const OrderBook::State& ob_state,
+                      std::vector<OrderReq_t>& reqs) const override;
 };
 }
 
@@ -286,14 +324,13 @@ public:
 
 namespace leyval {
 template<class PRNG>
-[[nodiscard]] std::vector<OrderReq_t>
+void
 Agent_JericevichFundamentalist<PRNG>::generate_order(
-  [[maybe_unused]] const OrderBook::State& ob_state) const
+  [[maybe_unused]] const OrderBook::State& ob_state,
+  std::vector<OrderReq_t>& reqs) const
 {
   // TODO: inter-arrival time governed by a truncated exponential distribution
 
-  std::vector<OrderReq_t> reqs{};
-
   int m_0{ 0 }; // TODO: implement
 
   if (this->m_timer.tick_and_check() == 0) {
@@ -312,132 +349,21 @@ Agent_JericevichFundamentalist<PRNG>::generate_order(
     reqs.emplace_back(MarketOrderReq{
       .volume = volume, .agent_id = this->get_id(), .order_dir = od });
   }
-
-  return reqs;
 }
 
 template<class PRNG>
-[[nodiscard]] std::vector<OrderReq_t>
+void
 Agent_JericevichChartist<PRNG>::generate_order(
-  [[maybe_unused]] const OrderBook::State& ob_state) const
+  [[maybe_unused]] const OrderBook::State& ob_state,
+  [[maybe_unused]] std::vector<OrderReq_t>& reqs) const
 {
 }
 
 template<class PRNG>
-[[nodiscard]] std::vector<OrderReq_t>
+void
 Agent_JericevichProvider<PRNG>::generate_order(
-  [[maybe_unused]] const OrderBook::State& ob_state) const
-{
-}
-
-template<class PRNG>
-[[nodiscard]] std::vector<OrderReq_t>
-Agent_JFProvider<PRNG>::generate_order(const OrderBook::State& ob_state) const
+  [[maybe_unused]] const OrderBook::State& ob_state,
+  [[maybe_unused]] std::vector<OrderReq_t>& reqs) const
 {
-  SPDLOG_TRACE("JFProvider::generate_order:: get_id: {}", this->get_id());
-
-  std::bernoulli_distribution place_order_prob(0.75);
-  std::bernoulli_distribution bid_prob(
-    static_cast<float>(ob_state.num_orders_ask) /
-    static_cast<float>(ob_state.num_orders_bid + ob_state.num_orders_ask));
-
-  std::vector<Money> price_offset;
-  std::vector<int> ws;
-  if (Money{ 150 } < ob_state.abs_spread) {
-    // Weight inwards (negative)
-    price_offset = { -2, -1, 0, 1, 2, 3 };
-    ws = { 3, 3, 4, 2, 2, 2 };
-  } else {
-    price_offset = { -1, 0, 1, 2, 3, 4, 5 };
-    ws = { 1, 3, 5, 4, 3, 2, 2 };
-  }
-
-  assert(price_offset.size() == ws.size());
-
-  std::discrete_distribution<> weights(ws.begin(), ws.end());
-  std::poisson_distribution volume(15);
-
-  std::vector<OrderReq_t> reqs{};
-
-  if (place_order_prob(this->m_prng)) {
-    if (bid_prob(this->m_prng)) {
-      // Cancel earliest LO
-      // TODO: Need a better way for agent to decide cancellation order_dir
-      // TODO: use orders_at_agentid_bid/ask to construct cor
-      reqs.emplace_back(
-        CancelOrderReq{ .volume = 0,
-                        .agent_id = this->get_id(),
-                        .price = 0,
-                        .order_dir = OrderDir::Bid,
-                        .lo_timestamp = std::chrono::steady_clock::now() });
-
-      // Create new LO
-      reqs.emplace_back(LimitOrderReq{
-        .volume = volume(this->m_prng),
-        .agent_id = this->get_id(),
-        .price = ob_state.best_price_bid - price_offset[weights(this->m_prng)],
-        .order_dir = OrderDir::Bid });
-      // Sometimes create another LO, to offset reduction from MO
-      if (bid_prob(this->m_prng)) {
-        reqs.emplace_back(
-          LimitOrderReq{ .volume = volume(this->m_prng),
-                         .agent_id = this->get_id(),
-                         .price = ob_state.best_price_bid -
-                                  price_offset[weights(this->m_prng)],
-                         .order_dir = OrderDir::Bid });
-      }
-    } else {
-      reqs.emplace_back(
-        CancelOrderReq{ .volume = 0,
-                        .agent_id = this->get_id(),
-                        .price = 0,
-                        .order_dir = OrderDir::Ask,
-                        .lo_timestamp = std::chrono::steady_clock::now() });
-      reqs.emplace_back(LimitOrderReq{
-        .volume = volume(this->m_prng),
-        .agent_id = this->get_id(),
-        .price = ob_state.best_price_ask + price_offset[weights(this->m_prng)],
-        .order_dir = OrderDir::Ask });
-
-      if (bid_prob(this->m_prng)) {
-        reqs.emplace_back(
-          LimitOrderReq{ .volume = volume(this->m_prng),
-                         .agent_id = this->get_id(),
-                         .price = ob_state.best_price_ask +
-                                  price_offset[weights(this->m_prng)],
-                         .order_dir = OrderDir::Ask });
-      }
-    }
-  }
-
-  return reqs;
-}
-
-template<class PRNG>
-[[nodiscard]] std::vector<OrderReq_t>
-Agent_JFTaker<PRNG>::generate_order(
-  [[maybe_unused]] const OrderBook::State& ob_state) const
-{
-  SPDLOG_TRACE("JFTaker::generate_order:: get_id: {}", this->get_id());
-
-  std::bernoulli_distribution place_order_prob(0.5);
-  std::bernoulli_distribution buy_prob(0.5);
-  std::poisson_distribution volume(2);
-
-  std::vector<OrderReq_t> reqs{};
-
-  if (place_order_prob(this->m_prng)) {
-    if (buy_prob(this->m_prng)) {
-      reqs.emplace_back(MarketOrderReq{ .volume = volume(this->m_prng),
-                                        .agent_id = this->get_id(),
-                                        .order_dir = OrderDir::Bid });
-    } else {
-      reqs.emplace_back(MarketOrderReq{ .volume = volume(this->m_prng),
-                                        .agent_id = this->get_id(),
-                                        .order_dir = OrderDir::Ask });
-    }
-  }
-
-  return reqs;
 }
 }
@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "event_log.hpp"
+
+static_assert(std::endian::native == std::endian::little,
+              "event logs are written in native byte order");
+static_assert(sizeof(int) == sizeof(std::int32_t));
+
+namespace {
+constexpr std::size_t alignment{ 8 };
+// n_events and reserved
+constexpr std::size_t block_header_size{ 2 * sizeof(std::uint32_t) };
+constexpr std::size_t file_header_size{ sizeof(leyval::event_log::magic) +
+                                        2 * sizeof(std::uint32_t) };
+
+constexpr std::size_t
+padding(std::size_t size)
+{
+  return (alignment - size % alignment) % alignment;
+}
+
+// Of a block of n events, without the padding
+constexpr std::size_t
+block_data_bytes(std::size_t n)
+{
+  return block_header_size + n * (3 * sizeof(std::int64_t) +
+                                  2 * sizeof(std::int32_t) +
+                                  2 * sizeof(std::uint8_t));
+}
+
+constexpr std::size_t
+block_size_bytes(std::size_t n)
+{
+  return block_data_bytes(n) + padding(block_data_bytes(n));
+}
+
+template<typename T>
+void
+write_column(std::ofstream& out, const std::vector<T>& column)
+{
+  out.write(reinterpret_cast<const char*>(column.data()),
+            static_cast<std::streamsize>(column.size() * sizeof(T)));
+}
+
+// Columns are laid out back to back, so each view starts where the last ended
+template<typename T>
+std::span<const T>
+take_column(const std::byte*& p, std::size_t n)
+{
+  const std::span<const T> column{ reinterpret_cast<const T*>(p), n };
+  p += n * sizeof(T);
+  return column;
+}
+
+std::int64_t
+pack(leyval::Timestamp timestamp)
+{
+  return (static_cast<std::int64_t>(timestamp.tick) << 32) | timestamp.seq;
+}
+
+leyval::Timestamp
+unpack(std::int64_t timestamp)
+{
+  return { .tick = static_cast<std::uint32_t>(timestamp >> 32),
+           .seq = static_cast<std::uint32_t>(timestamp) };
+}
+}
+
+namespace leyval::event_log {
+Event
+limit_order_event(const LimitOrderReq& lor, OrderId order_id)
+{
+  return { .timestamp = pack(lor.timestamp),
+           .type = EventType::limit_order,
+           .agent_id = lor.agent_id,
+           .price = lor.price.underlying_value,
+           .volume = lor.volume,
+           .direction = lor.order_dir,
+           .order_id = order_id };
+}
+
+Event
+market_order_event(const MarketOrderReq& mor)
+{
+  return { .timestamp = pack(mor.timestamp),
+           .type = EventType::market_order,
+           .agent_id = mor.agent_id,
+           .volume = mor.volume,
+           .direction = mor.order_dir };
+}
+
+Event
+cancel_order_event(const CancelOrderReq& cor)
+{
+  return { .timestamp = pack(cor.timestamp),
+           .type = EventType::cancel_order,
+           .agent_id = cor.agent_id,
+           .price = cor.price.underlying_value,
+           .volume = cor.volume,
+           .direction = cor.order_dir,
+           .order_id = cor.order_id.value_or(no_order_id) };
+}
+
+Event
+fill_event(const MarketOrderReq& mor, const TransactionRequest& trans)
+{
+  const OrderDir resting_dir{ !mor.order_dir };
+  return { .timestamp = pack(mor.timestamp),
+           .type = EventType::fill,
+           .agent_id = resting_dir == OrderDir::Bid ? trans.bidder_id
+                                                    : trans.asker_id,
+           .price = trans.price.underlying_value,
+           .volume = trans.volume,
+           .direction = resting_dir,
+           .order_id = trans.resting_order_id };
+}
+
+std::optional<OrderReq_t>
+to_order_request(const Event& event)
+{
+  switch (event.type) {
+    case EventType::limit_order:
+      return LimitOrderReq{ .volume = event.volume,
+                            .agent_id = event.agent_id,
+                            .price = Money{ event.price },
+                            .order_dir = event.direction,
+                            .timestamp = unpack(event.timestamp) };
+    case EventType::market_order:
+      return MarketOrderReq{ .volume = event.volume,
+                             .agent_id = event.agent_id,
+                             .order_dir = event.direction,
+                             .timestamp = unpack(event.timestamp) };
+    case EventType::cancel_order:
+      return CancelOrderReq{
+        .volume = event.volume,
+        .agent_id = event.agent_id,
+        .price = Money{ event.price },
+        .order_dir = event.direction,
+        .order_id = event.order_id == no_order_id
+                      ? std::nullopt
+                      : std::optional<OrderId>{ event.order_id },
+        .timestamp = unpack(event.timestamp)
+      };
+    case EventType::fill:
+      return std::nullopt;
+  }
+  throw std::invalid_argument("to_order_request: invalid EventType");
+}
+}
+
+namespace leyval {
+EventLogWriter::EventLogWriter(const std::filesystem::path& path,
+                               std::size_t block_size)
+  : m_out{ path, std::ios::binary | std::ios::trunc }
+  , m_block_size{ std::max(block_size, std::size_t{ 1 }) }
+{
+  if (!m_out) {
+    throw std::runtime_error("EventLogWriter: cannot open " + path.string());
+  }
+  const std::uint32_t reserved{ 0 };
+  m_out.write(event_log::magic, sizeof(event_log::magic));
+  m_out.write(reinterpret_cast<const char*>(&event_log::version),
+              sizeof(event_log::version));
+  m_out.write(reinterpret_cast<const char*>(&reserved), sizeof(reserved));
+  m_out.flush();
+
+  m_timestamp.reserve(m_block_size);
+  m_price.reserve(m_block_size);
+  m_order_id.reserve(m_block_size);
+  m_agent_id.reserve(m_block_size);
+  m_volume.reserve(m_block_size);
+  m_type.reserve(m_block_size);
+  m_direction.reserve(m_block_size);
+}
+
+EventLogWriter::~EventLogWriter()
+{
+  flush();
+}
+
+void
+EventLogWriter::append(const event_log::Event& event)
+{
+  m_timestamp.push_back(event.timestamp);
+  m_price.push_back(event.price);
+  m_order_id.push_back(event.order_id);
+  m_agent_id.push_back(event.agent_id);
+  m_volume.push_back(event.volume);
+  m_type.push_back(static_cast<std::uint8_t>(event.type));
+  m_direction.push_back(static_cast<std::uint8_t>(event.direction));
+
+  if (m_timestamp.size() == m_block_size) {
+    flush();
+  }
+}
+
+void
+EventLogWriter::flush()
+{
+  const std::size_t n{ m_timestamp.size() };
+  if (n == 0) {
+    return;
+  }
+
+  const std::uint32_t header[2]{ static_cast<std::uint32_t>(n), 0 };
+  m_out.write(reinterpret_cast<const char*>(header), sizeof(header));
+  write_column(m_out, m_timestamp);
+  write_column(m_out, m_price);
+  write_column(m_out, m_order_id);
+  write_column(m_out, m_agent_id);
+  write_column(m_out, m_volume);
+  write_column(m_out, m_type);
+  write_column(m_out, m_direction);
+  const char zeros[alignment]{};
+  m_out.write(zeros,
+              static_cast<std::streamsize>(padding(block_data_bytes(n))));
+  m_out.flush();
+
+  m_timestamp.clear();
+  m_price.clear();
+  m_order_id.clear();
+  m_agent_id.clear();
+  m_volume.clear();
+  m_type.clear();
+  m_direction.clear();
+}
+
+EventLogReader::EventLogReader(const std::filesystem::path& path)
+{
+  const int fd{ ::open(path.c_str(), O_RDONLY) };
+  if (fd < 0) {
+    throw std::runtime_error("EventLogReader: cannot open " + path.string());
+  }
+  struct stat st
+  {};
+  if (::fstat(fd, &st) != 0 ||
+      static_cast<std::size_t>(st.st_size) < file_header_size) {
+    ::close(fd);
+    throw std::runtime_error("EventLogReader: not an event log " +
+                             path.string());
+  }
+  m_length = static_cast<std::size_t>(st.st_size);
+  void* data{ ::mmap(nullptr, m_length, PROT_READ, MAP_PRIVATE, fd, 0) };
+  // The mapping stays valid once the descriptor is closed
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    throw std::runtime_error("EventLogReader: cannot map " + path.string());
+  }
+  m_data = static_cast<const std::byte*>(data);
+
+  std::uint32_t file_version{};
+  std::memcpy(&file_version,
+              m_data + sizeof(event_log::magic),
+              sizeof(file_version));
+  if (std::memcmp(m_data, event_log::magic, sizeof(event_log::magic)) != 0 ||
+      file_version != event_log::version) {
+    ::munmap(data, m_length);
+    throw std::runtime_error("EventLogReader: not an event log " +
+                             path.string());
+  }
+
+  std::size_t pos{ file_header_size };
+  while (m_length - pos >= block_header_size) {
+    std::uint32_t n{};
+    std::memcpy(&n, m_data + pos, sizeof(n));
+    const std::size_t size{ block_size_bytes(n) };
+    // Truncated by a crash, or corrupt
+    if (n == 0 || m_length - pos < size) {
+      break;
+    }
+
+    const std::byte* p{ m_data + pos + block_header_size };
+    event_log::Block block;
+    block.timestamp = take_column<std::int64_t>(p, n);
+    block.price = take_column<std::int64_t>(p, n);
+    block.order_id = take_column<std::uint64_t>(p, n);
+    block.agent_id = take_column<std::int32_t>(p, n);
+    block.volume = take_column<std::int32_t>(p, n);
+    block.type = take_column<std::uint8_t>(p, n);
+    block.direction = take_column<std::uint8_t>(p, n);
+    m_blocks.push_back(block);
+
+    m_size += n;
+    pos += size;
+  }
+}
+
+EventLogReader::~EventLogReader()
+{
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+  ::munmap(const_cast<std::byte*>(m_data), m_length);
+}
+}
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "matching_system.hpp"
+#include "order.hpp"
+
+// Journal of every order request and fill, stored column by column in blocks
+// of fixed-width fields. All integers are little-endian.
+//
+//   Header
+//     char[8]  magic "LEYVALEV"
+//     u32      version
+//     u32      reserved
+//   Block, repeated
+//     u32      n_events
+//     u32      reserved
+//     i64[n]   timestamp (Timestamp tick << 32 | seq)
+//     i64[n]   price (Money underlying_value)
+//     u64[n]   order_id
+//     i32[n]   agent_id
+//     i32[n]   volume
+//     u8[n]    type
+//     u8[n]    direction
+//     zero padding to a multiple of 8 bytes
+//
+// Every column starts 8-byte aligned, so a mapped file is read in place.
+// Blocks are written whole, so a crashed run leaves a readable prefix, and at
+// most one truncated block at the end, which the reader skips.
+namespace leyval {
+namespace event_log {
+constexpr char magic[8]{ 'L', 'E', 'Y', 'V', 'A', 'L', 'E', 'V' };
+constexpr std::uint32_t version{ 2 };
+constexpr OrderId no_order_id{ std::numeric_limits<OrderId>::max() };
+
+enum class EventType : std::uint8_t
+{
+  limit_order,
+  market_order,
+  cancel_order,
+  // Follows the market_order it belongs to
+  fill,
+};
+
+// For each type:
+//   limit_order   price, volume and direction of the order, and the OrderId
+//                 the book assigned to it
+//   market_order  volume and direction of the order
+//   cancel_order  direction, and the OrderId to cancel, or no_order_id for the
+//                 agent's earliest order
+//   fill          agent_id and OrderId of the resting order, and its side as
+//                 direction. The taker is the agent of the preceding
+//                 market_order.
+struct Event
+{
+  // Timestamp packed as tick << 32 | seq, so it orders the same.
+  // Fills take the Timestamp of their market order.
+  std::int64_t timestamp{ 0 };
+  EventType type{};
+  int agent_id{ 0 };
+  std::int64_t price{ 0 };
+  int volume{ 0 };
+  OrderDir direction{};
+  OrderId order_id{ no_order_id };
+
+  bool operator==(const Event&) const = default;
+};
+
+Event
+limit_order_event(const LimitOrderReq& lor, OrderId order_id);
+Event
+market_order_event(const MarketOrderReq& mor);
+Event
+cancel_order_event(const CancelOrderReq& cor);
+// trans is one of the fills of mor
+Event
+fill_event(const MarketOrderReq& mor, const TransactionRequest& trans);
+
+// Inverse of the *_order_event functions, with the request's timestamp
+// restored. Empty for fills, which are results rather than requests.
+std::optional<OrderReq_t>
+to_order_request(const Event& event);
+
+// Columns of one block, pointing into the mapped file
+struct Block
+{
+  std::span<const std::int64_t> timestamp;
+  std::span<const std::int64_t> price;
+  std::span<const std::uint64_t> order_id;
+  std::span<const std::int32_t> agent_id;
+  std::span<const std::int32_t> volume;
+  std::span<const std::uint8_t> type;
+  std::span<const std::uint8_t> direction;
+
+  [[nodiscard]] std::size_t size() const { return timestamp.size(); }
+
+  [[nodiscard]] Event operator[](std::size_t i) const
+  {
+    return { .timestamp = timestamp[i],
+             .type = static_cast<EventType>(type[i]),
+             .agent_id = agent_id[i],
+             .price = price[i],
+             .volume = volume[i],
+             .direction = static_cast<OrderDir>(direction[i]),
+             .order_id = order_id[i] };
+  }
+};
+}
+
+// Buffers events by column, and writes a block once block_size have been
+// appended. Appending does not allocate.
+class EventLogWriter
+{
+public:
+  static constexpr std::size_t default_block_size{ 4096 };
+
+  explicit EventLogWriter(const std::filesystem::path& path,
+                          std::size_t block_size = default_block_size);
+  EventLogWriter(const EventLogWriter&) = delete;
+  EventLogWriter& operator=(const EventLogWriter&) = delete;
+  ~EventLogWriter();
+
+  void append(const event_log::Event& event);
+
+  void limit_order(const LimitOrderReq& lor, OrderId order_id)
+  {
+    append(event_log::limit_order_event(lor, order_id));
+  }
+  void market_order(const MarketOrderReq& mor)
+  {
+    append(event_log::market_order_event(mor));
+  }
+  void cancel_order(const CancelOrderReq& cor)
+  {
+    append(event_log::cancel_order_event(cor));
+  }
+  void fill(const MarketOrderReq& mor, const TransactionRequest& trans)
+  {
+    append(event_log::fill_event(mor, trans));
+  }
+
+  // Writes buffered events as a (possibly short) block
+  void flush();
+
+private:
+  std::ofstream m_out;
+  std::size_t m_block_size;
+
+  std::vector<std::int64_t> m_timestamp;
+  std::vector<std::int64_t> m_price;
+  std::vector<std::uint64_t> m_order_id;
+  std::vector<std::int32_t> m_agent_id;
+  std::vector<std::int32_t> m_volume;
+  std::vector<std::uint8_t> m_type;
+  std::vector<std::uint8_t> m_direction;
+};
+
+// Maps an event log read-only. Events are read in place, without copying the
+// file.
+class EventLogReader
+{
+public:
+  // Throws std::runtime_error if path cannot be mapped, or is not an event log
+  explicit EventLogReader(const std::filesystem::path& path);
+  EventLogReader(const EventLogReader&) = delete;
+  EventLogReader& operator=(const EventLogReader&) = delete;
+  ~EventLogReader();
+
+  class const_iterator
+  {
+  public:
+    using iterator_concept = std::forward_iterator_tag;
+    using value_type = event_log::Event;
+    using difference_type = std::ptrdiff_t;
+
+    const_iterator() = default;
+    const_iterator(const std::vector<event_log::Block>* blocks,
+                   std::size_t block,
+                   std::size_t index)
+      : m_blocks{ blocks }
+      , m_block{ block }
+      , m_index{ index }
+    {
+    }
+
+    value_type operator*() const { return (*m_blocks)[m_block][m_index]; }
+
+    const_iterator& operator++()
+    {
+      if (++m_index == (*m_blocks)[m_block].size()) {
+        ++m_block;
+        m_index = 0;
+      }
+      return *this;
+    }
+    const_iterator operator++(int)
+    {
+      const_iterator prev{ *this };
+      ++*this;
+      return prev;
+    }
+
+    bool operator==(const const_iterator& other) const
+    {
+      return m_block == other.m_block && m_index == other.m_index;
+    }
+
+  private:
+    const std::vector<event_log::Block>* m_blocks{ nullptr };
+    std::size_t m_block{ 0 };
+    std::size_t m_index{ 0 };
+  };
+
+  [[nodiscard]] const_iterator begin() const { return { &m_blocks, 0, 0 }; }
+  [[nodiscard]] const_iterator end() const
+  {
+    return { &m_blocks, m_blocks.size(), 0 };
+  }
+
+  // For scanning single columns
+  [[nodiscard]] const std::vector<event_log::Block>& blocks() const
+  {
+    return m_blocks;
+  }
+  [[nodiscard]] std::size_t size() const { return m_size; }
+
+private:
+  const std::byte* m_data{ nullptr };
+  std::size_t m_length{ 0 };
+  std::vector<event_log::Block> m_blocks;
+  std::size_t m_size{ 0 };
+};
+static_assert(std::forward_iterator<EventLogReader::const_iterator>);
+}
@@ -1,53 +1,125 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <memory>
 #include <random>
+#include <span>
+#include <utility>
+#include <variant>
 
 #include "my_spdlog.hpp"
 #include "serializable.hpp"
 
-#include "agent.hpp"
 #include "constants.hpp"
+#include "event_log.hpp"
 #include "matching_system.hpp"
 #include "order.hpp"
 #include "order_book.hpp"
 #include "overloaded.hpp"
+#include "population.hpp"
+#include "util/thread_pool.hpp"
+#include "util/timing_wheel.hpp"
 
 namespace leyval {
-template<class PRNG>
+// Policy is the MatchingPolicy of the MatchingSystem. To pick it at runtime,
+// use make_exchange.
+template<class PRNG, MatchingPolicy Policy = FifoMatching>
 class Exchange
 {
 public:
-  using Agent_t = std::unique_ptr<Agent<PRNG>>;
-
   Exchange(OrderBook order_book,
-           std::vector<Agent_t> agents,
-           MatchingSystem matching_sys,
+           Population<PRNG> agents,
+           MatchingSystem<Policy> matching_sys,
            PRNG& prng)
     : m_order_book{ std::move(order_book) }
     , m_agents{ std::move(agents) }
-    , m_matching_sys{ matching_sys }
+    , m_matching_sys{ std::move(matching_sys) }
     , m_prng{ prng }
+    , m_schedule{ m_agents.size() }
   {
+    // Everyone decides in the first run()
+    for (int id{ 0 }; id < static_cast<int>(m_agents.size()); ++id) {
+      m_schedule.schedule(id, 1);
+    }
+    m_due.reserve(m_agents.size());
   }
 
-  // TODO: Add static tick count to help calculate agent's inter-arrival time
+  // Skips straight to the next tick at which some agent decides, and lets
+  // only those agents decide, so a tick costs O(deciding agents) rather than
+  // O(agents). With every agent deciding every tick, each run() is the next
+  // tick.
   void run();
 
+  // Agents decide on the same OrderBook::State, each from its own PRNG stream,
+  // so the decision phase of run() can be spread over num_threads.
+  // Requests are gathered per shard of agents and applied in agent order, so
+  // results are identical for any num_threads. 1 is serial.
+  void set_num_threads(std::size_t num_threads)
+  {
+    m_pool = num_threads > 1 ? std::make_unique<ThreadPool>(num_threads)
+                             : nullptr;
+  }
+
   void saturate();
 
+  // Journals every order request and fill from now on, including those of
+  // saturate(). Not owned, and nullptr stops journaling.
+  void set_event_log(EventLogWriter* event_log) { m_event_log = event_log; }
+
+  // Totals over every run() so far
+  struct Stats
+  {
+    // Limit, market and cancel order requests of agents
+    std::int64_t num_order_requests{ 0 };
+    int num_transactions{ 0 };
+    std::int64_t traded_volume{ 0 };
+    // Sum of price * volume over every fill
+    Money traded_notional{ 0 };
+  };
+
+  [[nodiscard]] const Stats& get_stats() const { return m_stats; }
+  [[nodiscard]] std::uint32_t get_tick() const { return m_clock.tick(); }
+  [[nodiscard]] const OrderBook& get_order_book() const { return m_order_book; }
+  [[nodiscard]] const Population<PRNG>& get_agents() const { return m_agents; }
+
 private:
   OrderBook m_order_book;
-  std::vector<Agent_t> m_agents;
-  MatchingSystem m_matching_sys;
+  Population<PRNG> m_agents;
+  MatchingSystem<Policy> m_matching_sys;
   PRNG& m_prng;
 
-  std::vector<OrderReq_t> m_current_order_requests;
+  Stats m_stats{};
+  // saturate() is tick 0, and each run() the next with agents due
+  SimClock m_clock;
+  // When each agent next decides
+  TimingWheel m_schedule;
+  // Agents deciding this tick, by type and then id, so that each type's
+  // kernel runs over as many agents at once as there are of that type
+  std::vector<int> m_due;
+  EventLogWriter* m_event_log{ nullptr };
+
+  std::unique_ptr<ThreadPool> m_pool;
+  // Requests of each shard of m_due, in its order. Cleared rather than freed
+  // every tick, so a tick in the steady state does not allocate.
+  std::vector<std::vector<OrderReq_t>> m_shard_order_requests;
+  // Every request of the tick, in agent order, and scratch for merging them
+  std::vector<OrderReq_t> m_order_requests;
+  std::vector<OrderReq_t> m_merged_order_requests;
 
+  void generate_orders(const OrderBook::State& ob_state);
+  // Merges the shards' requests into m_order_requests. Each type's requests
+  // come out of m_due in agent order, so this merges one run per type.
+  void gather_order_requests();
+  // Stamps order_request, and applies it to m_order_book
+  void apply(OrderReq_t& order_request);
+  void insert(LimitOrderReq lor);
   void execute(TransactionRequest trans);
 
   // https://github.com/nlohmann/json/issues/542#issuecomment-290665546
-  friend inline void to_json(nlohmann::json& j, const Exchange<PRNG>& exch)
+  friend inline void to_json(nlohmann::json& j, const Exchange& exch)
   {
     j = nlohmann::json{
       { "order_book", exch.m_order_book },
@@ -55,23 +127,60 @@ private:
       // NOTE: using this with to_json(..., MatchingSystem) does not compile
       { "matching_system", exch.m_matching_sys.get_type_string() }
     };
-    static_assert(Serializable<Exchange<PRNG>>);
+    static_assert(Serializable<Exchange>);
   }
-  friend struct fmt::formatter<Exchange<PRNG>>;
+  friend struct fmt::formatter<Exchange>;
 };
-}
+
+// Exchange over every MatchingPolicy, for choosing one at runtime
+template<class PRNG>
+using AnyExchange = std::variant<Exchange<PRNG, FifoMatching>,
+                                 Exchange<PRNG, ProRataMatching>,
+                                 Exchange<PRNG, RandomSelectionMatching>>;
 
 template<class PRNG>
-struct fmt::formatter<leyval::Exchange<PRNG>> : fmt::formatter<std::string_view>
+AnyExchange<PRNG>
+make_exchange(const MatchingConfig& config,
+              OrderBook order_book,
+              Population<PRNG> agents,
+              PRNG& prng)
 {
-  auto format(const leyval::Exchange<PRNG>& exchange,
+  switch (config.type) {
+    case MatchingType::fifo:
+      return Exchange<PRNG, FifoMatching>{ std::move(order_book),
+                                        std::move(agents),
+                                        MatchingSystem{ FifoMatching{} },
+                                        prng };
+    case MatchingType::pro_rata:
+      return Exchange<PRNG, ProRataMatching>{ std::move(order_book),
+                                        std::move(agents),
+                                        MatchingSystem{ ProRataMatching{} },
+                                        prng };
+    case MatchingType::random_selection:
+      return Exchange<PRNG, RandomSelectionMatching>{
+        std::move(order_book),
+        std::move(agents),
+        MatchingSystem{ RandomSelectionMatching{ config.rss_weight,
+                                                 config.rss_seed } },
+        prng
+      };
+  }
+  throw std::domain_error("make_exchange: invalid MatchingType");
+}
+}
+
+template<class PRNG, leyval::MatchingPolicy Policy>
+struct fmt::formatter<leyval::Exchange<PRNG, Policy>>
+  : fmt::formatter<std::string_view>
+{
+  auto format(const leyval::Exchange<PRNG, Policy>& exchange,
               format_context& ctx) const -> format_context::iterator;
 };
 
-template<class PRNG>
+template<class PRNG, leyval::MatchingPolicy Policy>
 auto
-fmt::formatter<leyval::Exchange<PRNG>>::format(
-  const leyval::Exchange<PRNG>& exchange,
+fmt::formatter<leyval::Exchange<PRNG, Policy>>::format(
+  const leyval::Exchange<PRNG, Policy>& exchange,
   format_context& ctx) const -> format_context::iterator
 {
   return fmt::format_to(ctx.out(),
@@ -82,22 +191,16 @@ fmt::formatter<leyval::Exchange<PRNG>>::format(
 
 namespace leyval {
 
-template<class PRNG>
+template<class PRNG, MatchingPolicy Policy>
 void
-Exchange<PRNG>::saturate()
+Exchange<PRNG, Policy>::saturate()
 {
   SPDLOG_DEBUG("Exchange::saturate: Init {}", m_order_book);
 
   // NOTE: Assert that highest bid < lowest ask
 
-  // NOTE: Strong assumption that no agent dies in-bewtween Exhange constructor
-  // and saturate
-  //       (and relying on Agent::new_id being sequential)
-  auto max_agent{ std::ranges::max_element(m_agents,
-                                           [](const auto& a1, const auto& a2) {
-                                             return a1->get_id() < a2->get_id();
-                                           }) };
-  std::uniform_int_distribution<> agent_id(1, (*max_agent)->get_id());
+  std::uniform_int_distribution<> agent_id(
+    1, static_cast<int>(m_agents.size()) - 1);
 
   using namespace constants::saturate;
   std::uniform_int_distribution<> bid_prices(price_center - price_far_offset,
@@ -112,99 +215,207 @@ Exchange<PRNG>::saturate()
   // TODO: maybe the orders that never get deleted in plot are from saturate?
   for ([[maybe_unused]] const int _ :
        std::views::iota(0, n_contracts_per_side)) {
-    m_order_book.insert({ .volume = volume(m_prng),
-                          .agent_id = agent_id(m_prng),
-                          .price = bid_prices(m_prng),
-                          .order_dir = OrderDir::Bid });
+    insert({ .volume = volume(m_prng),
+             .agent_id = agent_id(m_prng),
+             .price = bid_prices(m_prng),
+             .order_dir = OrderDir::Bid });
   }
 
   // Asks
   for ([[maybe_unused]] const int _ :
        std::views::iota(0, n_contracts_per_side)) {
-    m_order_book.insert({ .volume = volume(m_prng),
-                          .agent_id = agent_id(m_prng),
-                          .price = ask_prices(m_prng),
-                          .order_dir = OrderDir::Ask });
+    insert({ .volume = volume(m_prng),
+             .agent_id = agent_id(m_prng),
+             .price = ask_prices(m_prng),
+             .order_dir = OrderDir::Ask });
   }
 
   SPDLOG_DEBUG("Exchange::saturate: Post {}", m_order_book);
 }
 
-template<class PRNG>
+template<class PRNG, MatchingPolicy Policy>
 void
-Exchange<PRNG>::run()
+Exchange<PRNG, Policy>::run()
 {
-  const OrderBook::State ob_state{ m_order_book.update_get_state() };
-
-  for (const auto& agent : m_agents) {
-    SPDLOG_TRACE("Loop {}", *agent);
-    std::vector<OrderReq_t> new_order_reqs{ agent->generate_order(ob_state) };
-    if (!new_order_reqs.empty()) {
-      SPDLOG_TRACE("new_order is not empty");
-      for (const OrderReq_t order_req : new_order_reqs) {
-        SPDLOG_TRACE("\tPushing {}", order_req);
-        m_current_order_requests.push_back(order_req);
-      }
-    }
+  // Agents are rescheduled whenever they decide, so the wheel only runs dry
+  // without agents
+  const std::uint32_t tick{ m_schedule.next_tick().value_or(
+    m_clock.tick() + 1) };
+  m_clock.advance_to(tick);
+  m_schedule.advance_to(tick);
+  m_due.clear();
+  m_schedule.pop_due(m_due);
+  std::ranges::sort(m_due, {}, [this](int id) {
+    return std::pair{ m_agents.type(id), id };
+  });
+
+  const OrderBook::State ob_state{ m_order_book.get_state() };
+  generate_orders(ob_state);
+  for (const int id : m_due) {
+    m_schedule.schedule(id, m_agents.next_decision(id, tick));
   }
-  SPDLOG_DEBUG("After agents send requests: (current_order_requests)");
-  for ([[maybe_unused]] const auto& order_req : m_current_order_requests) {
+  // Applied in agent order, as before grouping by type, so that results do
+  // not depend on how agents are dispatched
+  gather_order_requests();
+  SPDLOG_DEBUG("After agents send requests: (order_requests)");
+  for ([[maybe_unused]] const auto& order_req : m_order_requests) {
     SPDLOG_TRACE("{}", order_req);
   }
 
   SPDLOG_DEBUG("========================================");
-  for (auto& order_request : m_current_order_requests) {
-    SPDLOG_TRACE("Loop {}", order_request);
-    std::visit(
-      overloaded{
-        [this](const LimitOrderReq& lor) {
-          SPDLOG_TRACE("LOR Visit");
-          m_order_book.insert(lor);
-        },
-        [this](MarketOrderReq& mor) {
-          SPDLOG_TRACE("MOR Visit");
-          auto transaction_requests{ m_matching_sys(mor, m_order_book) };
-          for (auto transaction_request : transaction_requests) {
-            SPDLOG_TRACE("{}", transaction_request);
-            execute(transaction_request);
+  for (auto& order_request : m_order_requests) {
+    apply(order_request);
+  }
+}
+
+template<class PRNG, MatchingPolicy Policy>
+void
+Exchange<PRNG, Policy>::apply(OrderReq_t& order_request)
+{
+  SPDLOG_TRACE("Loop {}", order_request);
+  ++m_stats.num_order_requests;
+  std::visit(
+    overloaded{
+      [this](const LimitOrderReq& lor) {
+        SPDLOG_TRACE("LOR Visit");
+        insert(lor);
+      },
+      [this](MarketOrderReq& mor) {
+        SPDLOG_TRACE("MOR Visit");
+        mor.timestamp = m_clock.stamp();
+        if (m_event_log) {
+          m_event_log->market_order(mor);
+        }
+        // Agents may draw a volume of 0, which has nothing to match
+        if (mor.volume <= 0) {
+          return;
+        }
+        for (const auto& transaction_request :
+             m_matching_sys(mor, m_order_book)) {
+          SPDLOG_TRACE("{}", transaction_request);
+          if (m_event_log) {
+            m_event_log->fill(mor, transaction_request);
           }
-        },
-        // TODO: Proper CancelOrder (remove specific LimitOrder in OrderBook)
-        // Just needs a way to uniquely identify LO
-        // Should have all same 5 fields as LO, plus self's timestamp
-        // All LOs in book should be unique on these 5 fields, mostly due to
-        // agent_id and timestamp
-
-        // TODO: Agents need to know what Orders they have in OrderBook.
-        //       Either memory or query book.
-        //         Memory means it would have to sync with transactions
-        //         In a simulation tick, the to-be-cancelled order could be
-        //         matched.
-        //           So Exchange.cancel() could fail with a valid CancelOrderReq
-        //       Could leverage that multimap.insert inserts at upperbound
-        //       (multimap is sorted on key - Money)
-        //         find_if(agent_id_comp) should always return largest bid
-        //
-
-        [this](CancelOrderReq& cor) {
-          SPDLOG_TRACE("COR Visit");
+          execute(transaction_request);
+        }
+      },
+      // TODO: Agents need to know what Orders they have in OrderBook.
+      //       Either memory or query book (orders_at_agentid).
+      //         Memory means it would have to sync with transactions
+      //         In a simulation tick, the to-be-cancelled order could be
+      //         matched.
+      //           So Exchange.cancel() could fail with a valid CancelOrderReq
+
+      [this](CancelOrderReq& cor) {
+        SPDLOG_TRACE("COR Visit");
+        cor.timestamp = m_clock.stamp();
+        if (m_event_log) {
+          m_event_log->cancel_order(cor);
+        }
+        if (cor.order_id) {
+          m_order_book.remove_specific_order(
+            cor.agent_id, *cor.order_id, cor.order_dir);
+        } else {
           m_order_book.remove_earliest_order(cor.agent_id, cor.order_dir);
-          // TODO: m_order_book.remove_specific_order(
-          //   cor.agent_id, cor.lo_timestamp, cor.order_dir);
-        } },
-      order_request);
+        }
+      } },
+    order_request);
+}
+
+template<class PRNG, MatchingPolicy Policy>
+void
+Exchange<PRNG, Policy>::generate_orders(const OrderBook::State& ob_state)
+{
+  for (auto& shard_reqs : m_shard_order_requests) {
+    shard_reqs.clear();
+  }
+  if (m_due.empty()) {
+    return;
+  }
+
+  // Several shards per thread, so that uneven shards still balance out
+  const std::size_t shards_per_thread{ 4 };
+  const std::size_t num_shards{
+    m_pool ? std::min(m_pool->size() * shards_per_thread, m_due.size()) : 1
+  };
+  const std::size_t shard_size{ (m_due.size() + num_shards - 1) /
+                                num_shards };
+  // Never shrunk, as the number of agents due varies from tick to tick
+  if (m_shard_order_requests.size() < num_shards) {
+    m_shard_order_requests.resize(num_shards);
+  }
+
+  auto generate_shard{ [&](std::size_t shard) {
+    const std::size_t first{ std::min(shard * shard_size, m_due.size()) };
+    const std::size_t last{ std::min(first + shard_size, m_due.size()) };
+    m_agents.generate_orders(ob_state,
+                             m_clock.tick(),
+                             std::span{ m_due }.subspan(first, last - first),
+                             m_shard_order_requests[shard]);
+  } };
+
+  if (m_pool) {
+    m_pool->parallel_for(num_shards, generate_shard);
+  } else {
+    generate_shard(0);
   }
-  m_current_order_requests.clear();
 }
 
-template<class PRNG>
+template<class PRNG, MatchingPolicy Policy>
 void
-Exchange<PRNG>::execute(TransactionRequest trans)
+Exchange<PRNG, Policy>::gather_order_requests()
 {
-  // NOTE: Treat asker/bidder_id as index of m_agents
-  //       Strongly assumes m_agents is in same order as Agent::new_id
+  auto agent_of{ [](const OrderReq_t& req) {
+    return std::visit([](const auto& r) { return r.agent_id; }, req);
+  } };
+
+  m_order_requests.clear();
+  for (auto& shard_reqs : m_shard_order_requests) {
+    std::ranges::move(shard_reqs, std::back_inserter(m_order_requests));
+  }
 
-  m_agents[trans.asker_id]->sell(trans.volume, trans.price);
-  m_agents[trans.bidder_id]->buy(trans.volume, trans.price);
+  // Merges the next run into the ones before it, until none is left
+  auto run_end{ std::ranges::is_sorted_until(
+    m_order_requests, {}, agent_of) };
+  while (run_end != m_order_requests.end()) {
+    const auto next_end{ std::ranges::is_sorted_until(
+      run_end, m_order_requests.end(), {}, agent_of) };
+    const auto merged{ next_end - m_order_requests.begin() };
+    m_merged_order_requests.clear();
+    std::ranges::merge(m_order_requests.begin(),
+                       run_end,
+                       run_end,
+                       next_end,
+                       std::back_inserter(m_merged_order_requests),
+                       {},
+                       agent_of,
+                       agent_of);
+    std::ranges::move(m_merged_order_requests, m_order_requests.begin());
+    run_end = m_order_requests.begin() + merged;
+  }
+}
+
+template<class PRNG, MatchingPolicy Policy>
+void
+Exchange<PRNG, Policy>::insert(LimitOrderReq lor)
+{
+  lor.timestamp = m_clock.stamp();
+  const OrderId order_id{ m_order_book.insert(lor) };
+  if (m_event_log) {
+    m_event_log->limit_order(lor, order_id);
+  }
+}
+
+template<class PRNG, MatchingPolicy Policy>
+void
+Exchange<PRNG, Policy>::execute(TransactionRequest trans)
+{
+  // trans.price is per share
+  const Money notional{ trans.price * trans.volume };
+  m_agents.sell(trans.asker_id, trans.volume, notional);
+  m_agents.buy(trans.bidder_id, trans.volume, notional);
+  ++m_stats.num_transactions;
+  m_stats.traded_volume += trans.volume;
+  m_stats.traded_notional += notional;
 }
 }
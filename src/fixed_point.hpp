@@ -1,163 +1,275 @@
 #pragma once
 
 #include <algorithm>
-#include <cmath>
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
 
 #include <fmt/core.h>
 
 #include "serializable.hpp"
 
 namespace leyval {
-template<int ScaleExp> // Scale Exponent for Base 10
+// What arithmetic on a Fixed does with a result that does not fit in 64 bits
+enum class Overflow
+{
+  // Nothing, for the hot path. 64 bits of cents is 92 quadrillion dollars.
+  unchecked,
+  // Throws std::overflow_error
+  checked,
+  // Clamps to the nearest representable value
+  saturating,
+};
+
+namespace fixed_point {
+// 10^i, for every power that fits in 64 bits
+inline constexpr std::array<std::int64_t, 19> pow10{ [] {
+  std::array<std::int64_t, 19> table{ 1 };
+  for (std::size_t i{ 1 }; i < table.size(); ++i) {
+    table[i] = table[i - 1] * 10;
+  }
+  return table;
+}() };
+
+template<Overflow Mode>
+constexpr std::int64_t
+overflowed(bool positive)
+{
+  if constexpr (Mode == Overflow::checked) {
+    throw std::overflow_error("Fixed: overflow");
+  }
+  return positive ? std::numeric_limits<std::int64_t>::max()
+                  : std::numeric_limits<std::int64_t>::min();
+}
+
+template<Overflow Mode>
+constexpr std::int64_t
+add(std::int64_t a, std::int64_t b)
+{
+  if constexpr (Mode == Overflow::unchecked) {
+    return a + b;
+  }
+  std::int64_t result{};
+  if (__builtin_add_overflow(a, b, &result)) [[unlikely]] {
+    return overflowed<Mode>(b > 0);
+  }
+  return result;
+}
+
+template<Overflow Mode>
+constexpr std::int64_t
+sub(std::int64_t a, std::int64_t b)
+{
+  if constexpr (Mode == Overflow::unchecked) {
+    return a - b;
+  }
+  std::int64_t result{};
+  if (__builtin_sub_overflow(a, b, &result)) [[unlikely]] {
+    return overflowed<Mode>(b < 0);
+  }
+  return result;
+}
+
+template<Overflow Mode>
+constexpr std::int64_t
+mul(std::int64_t a, std::int64_t b)
+{
+  if constexpr (Mode == Overflow::unchecked) {
+    return a * b;
+  }
+  std::int64_t result{};
+  if (__builtin_mul_overflow(a, b, &result)) [[unlikely]] {
+    return overflowed<Mode>((a < 0) == (b < 0));
+  }
+  return result;
+}
+
+template<Overflow Mode>
+constexpr std::int64_t
+div(std::int64_t a, std::int64_t b)
+{
+  // The only quotient that overflows
+  if constexpr (Mode != Overflow::unchecked) {
+    if (a == std::numeric_limits<std::int64_t>::min() && b == -1)
+      [[unlikely]] {
+      return overflowed<Mode>(true);
+    }
+  }
+  return a / b;
+}
+}
+
+// Integer arithmetic on underlying_value, in units of 10^ScaleExp.
+// Everything is constexpr 64-bit integer math, with scale factors from
+// fixed_point::pow10, so nothing goes through floating point except the
+// explicit conversion to float.
+template<int ScaleExp, Overflow Mode = Overflow::unchecked>
 struct Fixed
 {
-  Fixed(int val)
+  constexpr Fixed(std::int64_t val)
     : underlying_value{ val } {};
-  long underlying_value;
+  std::int64_t underlying_value;
 
-  explicit operator float() const
+  explicit constexpr operator float() const
   {
-    return underlying_value * std::pow(10, ScaleExp);
+    const auto value{ static_cast<double>(underlying_value) };
+    if constexpr (ScaleExp >= 0) {
+      return static_cast<float>(value * fixed_point::pow10[ScaleExp]);
+    } else {
+      return static_cast<float>(value / fixed_point::pow10[-ScaleExp]);
+    }
   }
 
+  // Going to a coarser scale truncates towards 0
   template<int NewScaleExp>
-  Fixed<NewScaleExp> rescale() const
+  constexpr Fixed<NewScaleExp, Mode> rescale() const
   {
-    return Fixed<NewScaleExp>(underlying_value *
-                              std::pow(10, ScaleExp - NewScaleExp));
+    constexpr int shift{ ScaleExp - NewScaleExp };
+    static_assert(-19 < shift && shift < 19,
+                  "Fixed::rescale: 10^shift does not fit in 64 bits");
+    if constexpr (shift >= 0) {
+      return { fixed_point::mul<Mode>(underlying_value,
+                                      fixed_point::pow10[shift]) };
+    } else {
+      return { underlying_value / fixed_point::pow10[-shift] };
+    }
   }
 
-  friend inline void to_json(nlohmann::json& j, const Fixed<ScaleExp>& f)
+  friend inline void to_json(nlohmann::json& j, const Fixed& f)
   {
     j = nlohmann::json{ f.underlying_value };
-    static_assert(Serializable<Fixed<ScaleExp>>);
+    static_assert(Serializable<Fixed>);
   }
 };
 
-template<int N>
-bool
-operator==(const Fixed<N>& a, const Fixed<N>& b)
+template<int N, Overflow O>
+constexpr bool
+operator==(const Fixed<N, O>& a, const Fixed<N, O>& b)
 {
   return a.underlying_value == b.underlying_value;
 }
 
-template<int N, int M>
-bool
-operator==(const Fixed<N>& a, const Fixed<M>& b)
+template<int N, int M, Overflow O>
+constexpr bool
+operator==(const Fixed<N, O>& a, const Fixed<M, O>& b)
 {
   return a == (b.template rescale<N>());
 }
 
-template<int N>
-std::strong_ordering
-operator<=>(const Fixed<N>& f1, const Fixed<N>& f2)
+template<int N, Overflow O>
+constexpr std::strong_ordering
+operator<=>(const Fixed<N, O>& f1, const Fixed<N, O>& f2)
 {
   return f1.underlying_value <=> f2.underlying_value;
 }
 
-template<int N, int M>
-std::strong_ordering
-operator<=>(const Fixed<N>& f1, const Fixed<M>& f2)
+template<int N, int M, Overflow O>
+constexpr std::strong_ordering
+operator<=>(const Fixed<N, O>& f1, const Fixed<M, O>& f2)
 {
   return f1.underlying_value <=> ((f2.template rescale<N>()).underlying_value);
 }
 
-template<int N>
-Fixed<N>
-operator+(const Fixed<N>& a, const Fixed<N>& b)
+template<int N, Overflow O>
+constexpr Fixed<N, O>
+operator+(const Fixed<N, O>& a, const Fixed<N, O>& b)
 {
-  // TODO: I don't know if long -> int is always safe in this type
-  return { static_cast<int>(a.underlying_value) +
-           static_cast<int>(b.underlying_value) };
+  return { fixed_point::add<O>(a.underlying_value, b.underlying_value) };
 }
 
-template<int N, int M>
-Fixed<std::min(N, M)>
-operator+(const Fixed<N>& a, const Fixed<M>& b)
+template<int N, int M, Overflow O>
+constexpr Fixed<std::min(N, M), O>
+operator+(const Fixed<N, O>& a, const Fixed<M, O>& b)
 {
   return (a.template rescale<std::min(N, M)>()) +
          (b.template rescale<std::min(N, M)>());
 }
 
-template<int N>
-Fixed<N>&
-operator+=(Fixed<N>& a, const Fixed<N>& b)
+template<int N, Overflow O>
+constexpr Fixed<N, O>&
+operator+=(Fixed<N, O>& a, const Fixed<N, O>& b)
 {
   a = a + b;
   return a;
 }
 
-template<int N, int M>
-Fixed<N>&
-operator+=(Fixed<N>& a, const Fixed<M>& b)
+template<int N, int M, Overflow O>
+constexpr Fixed<N, O>&
+operator+=(Fixed<N, O>& a, const Fixed<M, O>& b)
 {
-  a = a + b;
-  return a.template rescale<N>();
+  a = (a + b).template rescale<N>();
+  return a;
 }
 
-template<int N>
-Fixed<N>
-operator-(const Fixed<N>& a, const Fixed<N>& b)
+template<int N, Overflow O>
+constexpr Fixed<N, O>
+operator-(const Fixed<N, O>& a, const Fixed<N, O>& b)
 {
-  return { static_cast<int>(a.underlying_value) -
-           static_cast<int>(b.underlying_value) };
+  return { fixed_point::sub<O>(a.underlying_value, b.underlying_value) };
 }
 
-template<int N, int M>
-Fixed<std::min(N, M)>
-operator-(const Fixed<N>& a, const Fixed<M>& b)
+template<int N, int M, Overflow O>
+constexpr Fixed<std::min(N, M), O>
+operator-(const Fixed<N, O>& a, const Fixed<M, O>& b)
 {
   return (a.template rescale<std::min(N, M)>()) -
          (b.template rescale<std::min(N, M)>());
 }
 
-template<int N>
-Fixed<N>&
-operator-=(Fixed<N>& a, const Fixed<N>& b)
+template<int N, Overflow O>
+constexpr Fixed<N, O>&
+operator-=(Fixed<N, O>& a, const Fixed<N, O>& b)
 {
   a = a - b;
   return a;
 }
 
-template<int N, int M>
-Fixed<N>&
-operator-=(Fixed<N>& a, const Fixed<M>& b)
+template<int N, int M, Overflow O>
+constexpr Fixed<N, O>&
+operator-=(Fixed<N, O>& a, const Fixed<M, O>& b)
 {
-  a = a - b;
-  return a.template rescale<N>();
+  a = (a - b).template rescale<N>();
+  return a;
 }
 
-template<int N>
-Fixed<N>
-operator*(const Fixed<N>& a, const Fixed<N>& b)
+template<int N, Overflow O>
+constexpr Fixed<N, O>
+operator*(const Fixed<N, O>& a, const Fixed<N, O>& b)
 {
+  return { fixed_point::mul<O>(a.underlying_value, b.underlying_value) };
+}
 
-  return { static_cast<int>(a.underlying_value) *
-           static_cast<int>(b.underlying_value) };
+// Scales by a count, e.g. the notional of volume shares at a price
+template<int N, Overflow O>
+constexpr Fixed<N, O>
+operator*(const Fixed<N, O>& a, std::int64_t count)
+{
+  return { fixed_point::mul<O>(a.underlying_value, count) };
 }
 
-template<int N, int M>
-Fixed<std::max(N, M)>
-operator*(const Fixed<N>& a, const Fixed<M>& b)
+template<int N, int M, Overflow O>
+constexpr Fixed<std::max(N, M), O>
+operator*(const Fixed<N, O>& a, const Fixed<M, O>& b)
 {
   constexpr auto mm{ std::minmax({ N, M }) };
   return ((a.template rescale<mm.first>()) * (b.template rescale<mm.first>()))
     .template rescale<mm.second>();
 }
 
-template<int N>
-Fixed<N>
-operator/(const Fixed<N>& a, const Fixed<N>& b)
+template<int N, Overflow O>
+constexpr Fixed<N, O>
+operator/(const Fixed<N, O>& a, const Fixed<N, O>& b)
 {
-
-  return { static_cast<int>(a.underlying_value) /
-           static_cast<int>(b.underlying_value) };
+  return { fixed_point::div<O>(a.underlying_value, b.underlying_value) };
 }
 
-template<int N, int M>
-Fixed<std::max(N, M)>
-operator/(const Fixed<N>& a, const Fixed<M>& b)
+template<int N, int M, Overflow O>
+constexpr Fixed<std::max(N, M), O>
+operator/(const Fixed<N, O>& a, const Fixed<M, O>& b)
 {
   constexpr auto mm{ std::minmax({ N, M }) };
   return ((a.template rescale<mm.first>()) / (b.template rescale<mm.first>()))
@@ -165,9 +277,9 @@ operator/(const Fixed<N>& a, const Fixed<M>& b)
 }
 
 // Only for Catch2 printing
-template<int N>
+template<int N, Overflow O>
 std::ostream&
-operator<<(std::ostream& os, const Fixed<N>& f)
+operator<<(std::ostream& os, const Fixed<N, O>& f)
 {
   os << "Fixed<" << N << ">(" << f.underlying_value << ")";
   return os;
@@ -175,10 +287,10 @@ operator<<(std::ostream& os, const Fixed<N>& f)
 
 } // namespace leyval
 
-template<int N>
-struct fmt::formatter<leyval::Fixed<N>> : fmt::formatter<std::string_view>
+template<int N, leyval::Overflow O>
+struct fmt::formatter<leyval::Fixed<N, O>> : fmt::formatter<std::string_view>
 {
-  auto format(const leyval::Fixed<N>& f,
+  auto format(const leyval::Fixed<N, O>& f,
               format_context& ctx) const -> format_context::iterator
   {
     return fmt::format_to(ctx.out(), "Fixed<{}>({})", N, f.underlying_value);
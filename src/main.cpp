@@ -1,20 +1,30 @@
-#include <algorithm>
+#include <cstddef>
 #include <filesystem>
 #include <memory>
 #include <random>
 #include <ranges>
+#include <string>
 
 #include "my_spdlog.hpp"
 #include "serializable.hpp"
 
-#include "agent.hpp"
 #include "constants.hpp"
+#include "event_log.hpp"
 #include "exchange.hpp"
 #include "matching_system.hpp"
+#include "monte_carlo.hpp"
 #include "order_book.hpp"
+#include "population.hpp"
+#include "snapshot.hpp"
+#include "util/philox.hpp"
 
+// Usage: leyval [FIFO|Pro_Rata|RSS] [num_threads] [num_replications]
+// A single run streams a snapshot per tick to data/snapshots.bin, and every
+// order and fill to data/events.bin.
+// With more than one replication, runs them as a Monte Carlo batch over
+// num_threads, and writes only per run summaries.
 int
-main()
+main(int argc, char* argv[])
 {
   using namespace leyval;
   // Same format as default, but with YYMMDD instead of YYYY-MM-DD, and source
@@ -22,45 +32,65 @@ main()
   spdlog::set_pattern("[%C%m%d %T.%e] [%^%-8l%$] [%s:%# (%!)] %v");
   spdlog::set_level(spdlog::level::trace); // Set global log level
 
-  using PRNG = std::mt19937;
+  using PRNG = Philox4x32;
   std::random_device rd;
-  std::seed_seq seed{ rd(), rd(), rd(), rd(), rd(), rd() };
-  PRNG rng(seed);
-
-  std::uniform_int_distribution<> capital(80'000, 120'000);
-  std::vector<Exchange<PRNG>::Agent_t> agents{};
 
-  for (const int _ : std::views::iota(0, constants::n_providers)) {
-    agents.emplace_back(
-      std::make_unique<Agent_JFProvider<PRNG>>(capital(rng), rng));
+  MatchingConfig matching_config{};
+  if (argc > 1) {
+    matching_config.type = matching_type_from_string(argv[1]);
   }
+  const std::size_t num_threads{ argc > 2 ? std::stoul(argv[2]) : 1 };
+  const int num_replications{ argc > 3 ? std::stoi(argv[3]) : 1 };
+
+  std::filesystem::create_directory(constants::data_dir);
+
+  if (num_replications > 1) {
+    spdlog::set_level(spdlog::level::info);
+    const MonteCarloConfig config{ .num_replications = num_replications,
+                                   .seed = rd(),
+                                   .matching = matching_config,
+                                   .num_threads = num_threads };
 
-  for (const int _ : std::views::iota(0, constants::n_takers)) {
-    agents.emplace_back(
-      std::make_unique<Agent_JFTaker<PRNG>>(capital(rng), rng));
+    std::ofstream runs_file(constants::data_dir / "monte_carlo_runs.jsonl");
+    const MonteCarloSummary summary{ run_monte_carlo<PRNG>(
+      config, [&runs_file](const RunSummary& run) {
+        SPDLOG_INFO("Replication #{} finished", run.replication);
+        runs_file << nlohmann::json(run) << '\n';
+      }) };
+
+    std::ofstream out_file(constants::data_dir / "monte_carlo.json");
+    out_file << std::setw(2) << nlohmann::json(summary) << std::endl;
+    SPDLOG_INFO("MONTE CARLO FINISHED");
+    return 0;
   }
-  std::ranges::shuffle(
-    agents, rng); // NOTE: may want to not shuffle when grouping in python
 
-  Exchange exch{
-    OrderBook{}, std::move(agents), MatchingSystem{ MatchingSystem::fifo }, rng
-  };
+  std::seed_seq seed{ rd(), rd(), rd(), rd(), rd(), rd() };
+  PRNG rng(seed);
+  // As in run_replication, so RSS draws differ between runs too
+  matching_config.rss_seed = rng();
 
-  exch.saturate();
+  AnyExchange<PRNG> any_exch{ make_exchange(
+    matching_config, OrderBook{}, make_jf_agents(rng), rng) };
 
-  nlohmann::json exchange_states;
-  exchange_states.push_back(exch);
+  SnapshotWriter snapshots{ constants::data_dir / "snapshots.bin" };
+  EventLogWriter events{ constants::data_dir / "events.bin" };
+  std::visit(
+    [&snapshots, &events, num_threads](auto& exch) {
+      exch.set_num_threads(num_threads);
+      exch.set_event_log(&events);
+      exch.saturate();
+      snapshots.write(exch);
 
-  for ([[maybe_unused]] const int i : std::views::iota(0, constants::n_runs)) {
-    SPDLOG_INFO("Run #{} ***********************", i + 1);
-    exch.run();
-    exchange_states.push_back(exch);
-    SPDLOG_INFO("{}", exch);
-  }
+      for ([[maybe_unused]] const int i :
+           std::views::iota(0, constants::n_runs)) {
+        SPDLOG_INFO("Run #{} ***********************", i + 1);
+        exch.run();
+        snapshots.write(exch);
+        SPDLOG_INFO("{}", exch);
+      }
+    },
+    any_exch);
 
-  std::filesystem::create_directory(constants::data_dir);
-  std::ofstream out_file(constants::data_dir / "pretty.json");
-  out_file << std::setw(2) << exchange_states << std::endl;
   SPDLOG_INFO("SIMULATION FINISHED");
 
   return 0;
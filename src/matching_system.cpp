@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <cassert>
+#include <numeric>
 #include <ranges>
 
 #include "my_spdlog.hpp"
@@ -12,103 +14,201 @@ fmt::formatter<leyval::TransactionRequest>::format(
   format_context& ctx) const -> format_context::iterator
 {
   return fmt::format_to(ctx.out(),
-                        "(TREQ: {{bid_id: {}, ask_id: {}, prc: {}, vol: {}}})",
+                        "(TREQ: {{bid_id: {}, ask_id: {}, prc: {}, vol: {}, "
+                        "order_id: {}}})",
                         treq.bidder_id,
                         treq.asker_id,
                         treq.price,
-                        treq.volume);
+                        treq.volume,
+                        treq.resting_order_id);
 }
 
-auto
-fmt::formatter<leyval::MatchingSystem>::format(
-  const leyval::MatchingSystem& match_sys,
-  format_context& ctx) const -> format_context::iterator
+namespace leyval {
+namespace {
+// Copies the resting volumes of the best contra level into level.
+// Returns their sum.
+std::int64_t
+gather_best_level(OrderDir contra_dir,
+                  OrderBook& order_book,
+                  LevelVolumes& level)
 {
-  return fmt::format_to(
-    ctx.out(), "MatchingSystem({})", match_sys.get_type_string());
+  auto [level_begin, level_end]{ order_book.orders_at_best_price(contra_dir) };
+
+  level.volume.clear();
+  for (auto it{ level_begin }; it != level_end; ++it) {
+    level.volume.push_back(it->second.volume);
+  }
+  level.resize(level.volume.size());
+  return std::reduce(
+    level.volume.begin(), level.volume.end(), std::int64_t{ 0 });
 }
 
-namespace leyval {
-std::vector<TransactionRequest>
-MatchingSystem::operator()(const MarketOrderReq mor, OrderBook& order_book)
+// Fills the best contra level of mor by level.alloc
+void
+scatter_best_level(const MarketOrderReq& mor,
+                   const LevelVolumes& level,
+                   OrderBook& order_book,
+                   std::vector<TransactionRequest>& trans_reqs)
+{
+  const OrderDir contra_dir{ !mor.order_dir };
+  auto order_it{ order_book.orders_at_best_price(contra_dir).first };
+  const Money best_price{ order_it->first };
+
+  for (const int filled : level.alloc) {
+    const bool exhausted{ filled == order_it->second.volume };
+    if (filled > 0) {
+      trans_reqs.emplace_back(mor.agent_id,
+                              order_it->second.agent_id,
+                              filled,
+                              best_price,
+                              mor.order_dir,
+                              order_it->second.order_id);
+    }
+    order_it = order_book.fill_order(order_it, contra_dir, filled);
+    if (!exhausted) {
+      ++order_it;
+    }
+  }
+}
+}
+
+std::string_view
+matching_type_name(MatchingType type)
+{
+  switch (type) {
+    case MatchingType::fifo:
+      return FifoMatching::name;
+    case MatchingType::pro_rata:
+      return ProRataMatching::name;
+    case MatchingType::random_selection:
+      return RandomSelectionMatching::name;
+  }
+  throw std::domain_error("matching_type_name: invalid MatchingType");
+}
+
+MatchingType
+matching_type_from_string(std::string_view type_string)
+{
+  for (const MatchingType type : { MatchingType::fifo,
+                                   MatchingType::pro_rata,
+                                   MatchingType::random_selection }) {
+    if (type_string == matching_type_name(type)) {
+      return type;
+    }
+  }
+  throw std::invalid_argument(
+    fmt::format("matching_type_from_string: unknown type {}", type_string));
+}
+
+void
+pro_rata_allocate(int volume, LevelVolumes& level)
+{
+  const std::size_t n{ level.volume.size() };
+  const int* const vol{ level.volume.data() };
+  int* const alloc{ level.alloc.data() };
+  int* const rem{ level.remainder.data() };
+  int* const rank{ level.remainder_rank.data() };
+
+  const std::int64_t total{ std::reduce(vol, vol + n, std::int64_t{ 0 }) };
+  assert(0 < volume && volume < total);
+
+  // Weight and floor
+  for (std::size_t i{ 0 }; i < n; ++i) {
+    const std::int64_t weighted{ std::int64_t{ volume } * vol[i] };
+    alloc[i] = static_cast<int>(weighted / total);
+    rem[i] = (weighted % total) != 0;
+  }
+
+  // Remainder: rank[i] is the FIFO position of i among rounded down orders.
+  // Each rounded down order has room for one more share, and there are
+  // always at least as many of them as leftover shares.
+  const int leftover{ volume - std::reduce(alloc, alloc + n) };
+  std::inclusive_scan(rem, rem + n, rank);
+  for (std::size_t i{ 0 }; i < n; ++i) {
+    alloc[i] += rem[i] & (rank[i] <= leftover);
+  }
+}
+
+int
+ProRataMatching::fill_best_level(const MarketOrderReq& mor,
+                                 int volume,
+                                 OrderBook& order_book,
+                                 std::vector<TransactionRequest>& trans_reqs)
+{
+  const std::int64_t total{ gather_best_level(
+    !mor.order_dir, order_book, m_level_volumes) };
+  if (volume >= total) {
+    return fill_best_level_fifo(mor, volume, order_book, trans_reqs);
+  }
+
+  pro_rata_allocate(volume, m_level_volumes);
+  scatter_best_level(mor, m_level_volumes, order_book, trans_reqs);
+  return 0;
+}
+
+int
+RandomSelectionMatching::fill_best_level(
+  const MarketOrderReq& mor,
+  int volume,
+  OrderBook& order_book,
+  std::vector<TransactionRequest>& trans_reqs)
 {
-  SPDLOG_DEBUG("MS Invoke");
-  assert(mor.volume > 0 && "MarketOrderReq must be positive");
-
-  std::vector<TransactionRequest> trans_reqs{};
-  switch (m_type) {
-    case fifo: {
-      // Each share traded needs to recalculate the best price
-      for ([[maybe_unused]] const int i : std::views::iota(0, mor.volume)) {
-        SPDLOG_TRACE("MS::(FIFO) Loop {}", i);
-
-        const OrderDir contra_dir{ !mor.order_dir };
-        auto best_contra_orders{ order_book.orders_at_best_price(contra_dir) };
-        Money best_price = best_contra_orders.first
-                             ->first; // best_contra_orders.first_iterator->key
-                                      // (arbitrarily use first iterator)
-
-        SPDLOG_TRACE("best_contra_orders.first->second: a_id: {}, {}, vol: {}",
-                     best_contra_orders.first->second.agent_id,
-                     best_contra_orders.first->second.order_dir,
-                     best_contra_orders.first->second.volume);
-        SPDLOG_TRACE("MS:: best_price: {}", best_price);
-
-        // Pop earliest-timestamp LimitOrderVal at best_price
-        auto early_comp = [](const LimitOrder& lo1, const LimitOrder& lo2) {
-          return lo1.second.timestamp < lo2.second.timestamp;
-        };
-
-        auto earliest_best_order{ std::min_element(
-          best_contra_orders.first, best_contra_orders.second, early_comp) };
-
-        SPDLOG_TRACE("earliest_best_order->second.agent_id: {}",
-                     earliest_best_order->second.agent_id);
-
-        // TODO: Does this ever fail to prematurely break?
-        // Why would earliest_best_order never be seen in this iteration?
-        // If no break, would the transactionreq even be valid?
-        for (auto it = best_contra_orders.first;
-             it != best_contra_orders.second;) {
-          if (it == earliest_best_order) {
-            it = order_book.remove_order(it, contra_dir);
-            break;
-          } else {
-            ++it;
-          };
-        }
-
-        trans_reqs.emplace_back(
-          TransactionRequest(mor.agent_id,
-                             earliest_best_order->second.agent_id,
-                             earliest_best_order->second.volume,
-                             best_price,
-                             mor.order_dir));
-      }
-      break;
+  const OrderDir contra_dir{ !mor.order_dir };
+  // Kept by the book as orders come and go, rather than rebuilt per order
+  PriceLadder::LevelWeights& weights{ order_book.best_level_weights(
+    contra_dir) };
+  if (volume >= weights.volume.total()) {
+    return fill_best_level_fifo(mor, volume, order_book, trans_reqs);
+  }
+
+  FenwickTree<std::int64_t>& tree{ m_weight == RssWeight::volume
+                                     ? weights.volume
+                                     : weights.count };
+  std::vector<int>& alloc{ m_alloc };
+  alloc.assign(weights.slots.size(), 0);
+  auto resting{ [&](std::size_t slot) {
+    return order_book.order_at(contra_dir, weights.slots[slot])->second.volume;
+  } };
+
+  // One share at a time, taking each share's weight out of the tree as it is
+  // drawn
+  for ([[maybe_unused]] const int _ : std::views::iota(0, volume)) {
+    std::uniform_int_distribution<std::int64_t> draw(0, tree.total() - 1);
+    const std::size_t i{ tree.find(draw(m_prng)) };
+    ++alloc[i];
+    if (m_weight == RssWeight::volume || alloc[i] == resting(i)) {
+      tree.add(i, -1);
     }
+  }
+  // Put the drawn weight back, as filling takes it out for good
+  for (std::size_t i{ 0 }; i < alloc.size(); ++i) {
+    if (alloc[i] == 0) {
+      continue;
+    }
+    if (m_weight == RssWeight::volume) {
+      tree.add(i, alloc[i]);
+    } else if (alloc[i] == resting(i)) {
+      tree.add(i, 1);
+    }
+  }
 
-      // Defer to Exchange::execute_transaction}
-
-    case pro_rata: {
-      // TODO: Implement pro_rata
-      // mor.volume = 11, total limit size = 100 (3 orders of 20, 30, 50)
-      // weight = 11 / 100
-      // shares_per_order = (20, 30, 50) .* weight -> floor/round
-      // excess = total limit size - sum(shares_per_order)
-      // if excess > 0: FIFO the excess
-
-      [[maybe_unused]] auto best_contra_orders{ order_book.orders_at_best_price(
-        mor.order_dir) };
-      [[maybe_unused]] int total_orders{ 5 };
-      [[maybe_unused]] double weight{ static_cast<double>(mor.volume) /
-                                      total_orders };
-      break;
+  // Slots are in time priority, and stay put while the level fills
+  const Money best_price{
+    order_book.orders_at_best_price(contra_dir).first->first
+  };
+  for (std::size_t i{ 0 }; i < alloc.size(); ++i) {
+    if (alloc[i] == 0) {
+      continue;
     }
-    case random_selection:
-      // TODO: Implement random_selection
-      break;
+    const auto order_it{ order_book.order_at(contra_dir, weights.slots[i]) };
+    trans_reqs.emplace_back(mor.agent_id,
+                            order_it->second.agent_id,
+                            alloc[i],
+                            best_price,
+                            mor.order_dir,
+                            order_it->second.order_id);
+    order_book.fill_order(order_it, contra_dir, alloc[i]);
   }
-  return trans_reqs;
-};
+  return 0;
+}
 }
@@ -1,10 +1,22 @@
 #pragma once
 
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <random>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "my_spdlog.hpp"
 
 #include "order.hpp"
 #include "order_book.hpp"
 #include "serializable.hpp"
+#include "util/fenwick_tree.hpp"
 
 namespace leyval {
 struct TransactionRequest
@@ -13,14 +25,18 @@ struct TransactionRequest
   int asker_id;
   int volume;
   Money price;
+  // Of the resting order that was filled
+  OrderId resting_order_id;
 
   TransactionRequest(int initiator_agent,
                      int provider_agent,
                      int _volume,
                      Money _price,
-                     OrderDir market_order_dir)
+                     OrderDir market_order_dir,
+                     OrderId _resting_order_id)
     : volume{ _volume }
     , price{ _price }
+    , resting_order_id{ _resting_order_id }
   {
     switch (market_order_dir) {
       case OrderDir::Bid:
@@ -37,7 +53,8 @@ struct TransactionRequest
   }
 };
 }
-// TransactionRequest(initiator_agent, provider_agent, volume, price, order_dir)
+// TransactionRequest(initiator_agent, provider_agent, volume, price, order_dir,
+//                    resting_order_id)
 
 template<>
 struct fmt::formatter<leyval::TransactionRequest>
@@ -49,49 +66,254 @@ struct fmt::formatter<leyval::TransactionRequest>
 
 //////////////////////////////////////////////////////////
 
-// TODO: Think about splitting MatchingSystem to concept or abstract base class
 namespace leyval {
-class MatchingSystem
+// Structure-of-arrays view of the resting volumes of one price level, in time
+// priority. Kept by a MatchingPolicy between market orders, so the buffers are
+// only reallocated when a larger level is seen.
+struct LevelVolumes
 {
-public:
-  enum Type
+  std::vector<int> volume;
+  std::vector<int> alloc;
+  // 1 if alloc was rounded down, and its inclusive scan
+  std::vector<int> remainder;
+  std::vector<int> remainder_rank;
+
+  void resize(std::size_t n)
   {
-    fifo,
-    pro_rata,
-    random_selection,
+    volume.resize(n);
+    alloc.resize(n);
+    remainder.resize(n);
+    remainder_rank.resize(n);
+  }
+};
+
+// Pro-rata allocation of volume over level, where 0 < volume < sum(volume):
+//   alloc[i] = floor(volume * level.volume[i] / sum(level.volume))
+// The leftover shares are then handed out FIFO, one each to the earliest
+// orders whose allocation was rounded down.
+// Loops are kept branch-free over contiguous arrays, so they auto-vectorize.
+void
+pro_rata_allocate(int volume, LevelVolumes& level);
+
+// Fills up to volume against the best contra level of mor, in time
+// priority. Appends one TransactionRequest per touched order.
+// Returns volume left over once the level is exhausted.
+inline int
+fill_best_level_fifo(const MarketOrderReq& mor,
+                     int volume,
+                     OrderBook& order_book,
+                     std::vector<TransactionRequest>& trans_reqs)
+{
+  const OrderDir contra_dir{ !mor.order_dir };
+  auto [order_it, level_end]{ order_book.orders_at_best_price(contra_dir) };
+  const Money best_price{ order_it->first };
+  SPDLOG_TRACE("MS::(FIFO) best_price: {}", best_price);
+
+  while (volume > 0 && order_it != level_end) {
+    const int filled{ std::min(volume, order_it->second.volume) };
+    if (filled > 0) {
+      trans_reqs.emplace_back(mor.agent_id,
+                              order_it->second.agent_id,
+                              filled,
+                              best_price,
+                              mor.order_dir,
+                              order_it->second.order_id);
+    }
+    volume -= filled;
+    order_it = order_book.fill_order(order_it, contra_dir, filled);
+  }
+  return volume;
+}
+}
+
+namespace leyval {
+enum class MatchingType
+{
+  fifo,
+  pro_rata,
+  random_selection,
+};
+
+std::string_view
+matching_type_name(MatchingType type);
+
+// Inverse of matching_type_name
+MatchingType
+matching_type_from_string(std::string_view type_string);
+
+// How RandomSelectionMatching draws the order that the next share goes to
+enum class RssWeight
+{
+  volume,  // proportional to remaining resting volume
+  uniform, // equally among orders with remaining volume
+};
+
+// Runtime choice of MatchingPolicy, see make_exchange
+struct MatchingConfig
+{
+  MatchingType type{ MatchingType::fifo };
+  RssWeight rss_weight{ RssWeight::volume };
+  std::mt19937::result_type rss_seed{ std::mt19937::default_seed };
+};
+
+// Allocates (part of) a MarketOrderReq against the best contra level.
+// fill_best_level has the same contract as fill_best_level_fifo.
+template<typename T>
+concept MatchingPolicy =
+  requires(T policy,
+           const MarketOrderReq& mor,
+           int volume,
+           OrderBook& order_book,
+           std::vector<TransactionRequest>& trans_reqs) {
+    { T::type } -> std::convertible_to<MatchingType>;
+    { T::name } -> std::convertible_to<std::string_view>;
+    {
+      policy.fill_best_level(mor, volume, order_book, trans_reqs)
+    } -> std::same_as<int>;
   };
 
-  MatchingSystem(Type type)
-    : m_type{ type }
+struct FifoMatching
+{
+  static constexpr MatchingType type{ MatchingType::fifo };
+  static constexpr std::string_view name{ "FIFO" };
+
+  int fill_best_level(const MarketOrderReq& mor,
+                      int volume,
+                      OrderBook& order_book,
+                      std::vector<TransactionRequest>& trans_reqs)
   {
+    return fill_best_level_fifo(mor, volume, order_book, trans_reqs);
   }
+};
 
-  std::vector<TransactionRequest> operator()(const MarketOrderReq mo,
-                                             OrderBook& order_book);
+class ProRataMatching
+{
+public:
+  static constexpr MatchingType type{ MatchingType::pro_rata };
+  static constexpr std::string_view name{ "Pro_Rata" };
 
-  [[nodiscard]] Type get_type() const { return m_type; }
-  [[nodiscard]] std::string get_type_string() const
+  int fill_best_level(const MarketOrderReq& mor,
+                      int volume,
+                      OrderBook& order_book,
+                      std::vector<TransactionRequest>& trans_reqs);
+
+private:
+  LevelVolumes m_level_volumes;
+};
+
+// Draws each share at random, one at a time, from the weights the OrderBook
+// keeps for each level, so a market order costs O(volume * log(level size)).
+// Draws from its own stream, so runs are reproducible from the seed alone,
+// independent of the agents' PRNG.
+class RandomSelectionMatching
+{
+public:
+  using PRNG = std::mt19937;
+  static constexpr MatchingType type{ MatchingType::random_selection };
+  static constexpr std::string_view name{ "RSS" };
+
+  explicit RandomSelectionMatching(
+    RssWeight weight = RssWeight::volume,
+    PRNG::result_type seed = PRNG::default_seed)
+    : m_weight{ weight }
+    , m_prng{ seed }
   {
-    switch (m_type) {
-      case fifo:
-        return "FIFO";
-      case pro_rata:
-        return "Pro_Rata";
-      case random_selection:
-        return "RSS";
-      default:
-        throw std::invalid_argument("MatchingSystem::get_type_string()");
-    }
   }
 
+  int fill_best_level(const MarketOrderReq& mor,
+                      int volume,
+                      OrderBook& order_book,
+                      std::vector<TransactionRequest>& trans_reqs);
+
 private:
-  Type m_type;
+  RssWeight m_weight;
+  PRNG m_prng;
+  // Shares drawn per LevelWeights slot
+  std::vector<int> m_alloc;
 };
+
+static_assert(MatchingPolicy<FifoMatching>);
+static_assert(MatchingPolicy<ProRataMatching>);
+static_assert(MatchingPolicy<RandomSelectionMatching>);
+
+// Sweeps levels of the OrderBook with Policy.
+// Policy is fixed at compile time, so each instantiation has its own inlined
+// matching path.
+template<MatchingPolicy Policy>
+class MatchingSystem
+{
+public:
+  explicit MatchingSystem(Policy policy = Policy{})
+    : m_policy{ std::move(policy) }
+  {
+  }
+
+  // The result is overwritten by the next call, which then does not allocate
+  // unless it has more fills than any call before it.
+  const std::vector<TransactionRequest>& operator()(const MarketOrderReq mor,
+                                                    OrderBook& order_book);
+
+  [[nodiscard]] static constexpr MatchingType get_type()
+  {
+    return Policy::type;
+  }
+  [[nodiscard]] static std::string get_type_string()
+  {
+    return std::string{ Policy::name };
+  }
+
+private:
+  Policy m_policy;
+  std::vector<TransactionRequest> m_trans_reqs;
+};
+
+// Including with RandomSelectionMatching, whose default constructor is explicit
+static_assert(
+  std::is_default_constructible_v<MatchingSystem<RandomSelectionMatching>>);
 } // namespace leyval
 
-template<>
-struct fmt::formatter<leyval::MatchingSystem> : fmt::formatter<std::string_view>
+template<leyval::MatchingPolicy Policy>
+struct fmt::formatter<leyval::MatchingSystem<Policy>>
+  : fmt::formatter<std::string_view>
 {
-  auto format(const leyval::MatchingSystem& match_sys,
-              format_context& ctx) const -> format_context::iterator;
+  auto format(const leyval::MatchingSystem<Policy>& match_sys,
+              format_context& ctx) const -> format_context::iterator
+  {
+    return fmt::format_to(
+      ctx.out(), "MatchingSystem({})", match_sys.get_type_string());
+  }
 };
+
+// Impls //////////////////////////////////////////////////////////////////////
+
+namespace leyval {
+template<MatchingPolicy Policy>
+const std::vector<TransactionRequest>&
+MatchingSystem<Policy>::operator()(const MarketOrderReq mor,
+                                   OrderBook& order_book)
+{
+  SPDLOG_DEBUG("MS Invoke");
+  assert(mor.volume > 0 && "MarketOrderReq must be positive");
+
+  std::vector<TransactionRequest>& trans_reqs{ m_trans_reqs };
+  trans_reqs.clear();
+
+  // Sweep levels from the best price outwards, until filled or the contra
+  // side runs out. A MOR larger than a level takes all of it.
+  const OrderDir contra_dir{ !mor.order_dir };
+  int remaining{ mor.volume };
+  while (remaining > 0 && !order_book.empty(contra_dir)) {
+    remaining =
+      m_policy.fill_best_level(mor, remaining, order_book, trans_reqs);
+  }
+  if (remaining > 0) {
+    SPDLOG_DEBUG("MS::({}) {} unfilled, no {} orders left",
+                 Policy::name,
+                 remaining,
+                 contra_dir);
+  }
+
+  // Defer to Exchange::execute_transaction
+  return trans_reqs;
+}
+}
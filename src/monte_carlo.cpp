@@ -0,0 +1,44 @@
+#include "monte_carlo.hpp"
+
+namespace leyval {
+void
+MonteCarloSummary::add(const RunSummary& run)
+{
+  num_transactions.add(run.num_transactions);
+  traded_volume.add(static_cast<double>(run.traded_volume));
+  final_mid_price.add(static_cast<float>(run.final_mid_price));
+  final_abs_spread.add(static_cast<float>(run.final_abs_spread));
+}
+
+void
+to_json(nlohmann::json& j, const RunningStats& stats)
+{
+  j = nlohmann::json{ { "count", stats.count() },
+                      { "mean", stats.mean() },
+                      { "stddev", stats.stddev() },
+                      { "min", stats.min() },
+                      { "max", stats.max() } };
+}
+static_assert(Serializable<RunningStats>);
+
+void
+to_json(nlohmann::json& j, const RunSummary& run)
+{
+  j = nlohmann::json{ { "replication", run.replication },
+                      { "num_transactions", run.num_transactions },
+                      { "traded_volume", run.traded_volume },
+                      { "final_mid_price", run.final_mid_price },
+                      { "final_abs_spread", run.final_abs_spread } };
+}
+static_assert(Serializable<RunSummary>);
+
+void
+to_json(nlohmann::json& j, const MonteCarloSummary& summary)
+{
+  j = nlohmann::json{ { "num_transactions", summary.num_transactions },
+                      { "traded_volume", summary.traded_volume },
+                      { "final_mid_price", summary.final_mid_price },
+                      { "final_abs_spread", summary.final_abs_spread } };
+}
+static_assert(Serializable<MonteCarloSummary>);
+}
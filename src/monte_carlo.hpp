@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <variant>
+
+#include "serializable.hpp"
+
+#include "constants.hpp"
+#include "exchange.hpp"
+#include "matching_system.hpp"
+#include "order_book.hpp"
+#include "population.hpp"
+#include "util/running_stats.hpp"
+#include "util/thread_pool.hpp"
+
+namespace leyval {
+struct MonteCarloConfig
+{
+  int num_replications{ 1 };
+  int num_ticks{ constants::n_runs };
+  // Replication i is seeded from (seed, i) only, so it is reproducible on its
+  // own, and independent of num_threads
+  std::uint32_t seed{ 0 };
+  MatchingConfig matching{};
+  // Replications run concurrently, each Exchange itself is serial
+  std::size_t num_threads{ 1 };
+};
+
+// End of one replication
+struct RunSummary
+{
+  int replication{ 0 };
+  int num_transactions{ 0 };
+  std::int64_t traded_volume{ 0 };
+  Money final_mid_price{ 0 };
+  Money final_abs_spread{ 0 };
+};
+
+// Aggregate over replications, updated as each one finishes
+struct MonteCarloSummary
+{
+  RunningStats num_transactions;
+  RunningStats traded_volume;
+  RunningStats final_mid_price;
+  RunningStats final_abs_spread;
+
+  void add(const RunSummary& run);
+};
+
+void
+to_json(nlohmann::json& j, const RunningStats& stats);
+
+void
+to_json(nlohmann::json& j, const RunSummary& run);
+
+void
+to_json(nlohmann::json& j, const MonteCarloSummary& summary);
+
+template<class PRNG>
+RunSummary
+run_replication(const MonteCarloConfig& config, int replication)
+{
+  std::seed_seq seq{ config.seed, static_cast<std::uint32_t>(replication) };
+  PRNG rng(seq);
+
+  MatchingConfig matching{ config.matching };
+  matching.rss_seed = rng();
+  AnyExchange<PRNG> any_exch{ make_exchange(
+    matching, OrderBook{}, make_jf_agents(rng), rng) };
+
+  return std::visit(
+    [&](auto& exch) {
+      exch.saturate();
+      for (int tick{ 0 }; tick < config.num_ticks; ++tick) {
+        exch.run();
+      }
+      const OrderBook::State& state{ exch.get_order_book().get_state() };
+      return RunSummary{ .replication = replication,
+                         .num_transactions = exch.get_stats().num_transactions,
+                         .traded_volume = exch.get_stats().traded_volume,
+                         .final_mid_price = state.mid_price,
+                         .final_abs_spread = state.abs_spread };
+    },
+    any_exch);
+}
+
+// Runs config.num_replications independent Exchanges over config.num_threads.
+// Idle threads take the next replication as soon as they finish one.
+// on_run(const RunSummary&) is called once per replication, in the order they
+// finish, and never concurrently. Only the summaries are kept, so memory does
+// not grow with num_replications. If a replication throws, the ones not yet
+// started are skipped and the exception is rethrown here.
+template<class PRNG, typename OnRun>
+MonteCarloSummary
+run_monte_carlo(const MonteCarloConfig& config, OnRun on_run)
+{
+  MonteCarloSummary summary{};
+  std::mutex summary_mutex;
+
+  ThreadPool pool{ config.num_threads };
+  pool.parallel_for(config.num_replications, [&](std::size_t replication) {
+    const RunSummary run{ run_replication<PRNG>(
+      config, static_cast<int>(replication)) };
+
+    std::lock_guard lock{ summary_mutex };
+    summary.add(run);
+    on_run(run);
+  });
+  return summary;
+}
+
+template<class PRNG>
+MonteCarloSummary
+run_monte_carlo(const MonteCarloConfig& config)
+{
+  return run_monte_carlo<PRNG>(config, [](const RunSummary&) {});
+}
+}
@@ -20,6 +20,14 @@ fmt::formatter<leyval::OrderDir>::format(const leyval::OrderDir& od,
     ctx.out(), "OrderDir {}", od == leyval::OrderDir::Bid ? "Bid" : "Ask");
 }
 
+auto
+fmt::formatter<leyval::Timestamp>::format(const leyval::Timestamp& ts,
+                                          format_context& ctx) const
+  -> format_context::iterator
+{
+  return fmt::format_to(ctx.out(), "t{}.{}", ts.tick, ts.seq);
+}
+
 namespace leyval {
 OrderDir
 operator!(OrderDir order_dir)
@@ -61,8 +69,7 @@ fmt::formatter<leyval::MarketOrderReq>::format(
                         mor.agent_id,
                         mor.volume,
                         mor.order_dir,
-                        std::chrono::duration_cast<std::chrono::microseconds>(
-                          mor.timestamp - leyval::INIT_TS));
+                        mor.timestamp);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -101,8 +108,7 @@ fmt::formatter<leyval::LimitOrderReq>::format(const leyval::LimitOrderReq& lor,
                         lor.price,
                         lor.volume,
                         lor.order_dir,
-                        std::chrono::duration_cast<std::chrono::microseconds>(
-                          lor.timestamp - leyval::INIT_TS));
+                        lor.timestamp);
 }
 ////////////////////////////////////////////////////////////////////////////////
 
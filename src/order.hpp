@@ -1,8 +1,9 @@
 #pragma once
 
-#include <chrono>
+#include <compare>
+#include <cstdint>
+#include <optional>
 
-#include <fmt/chrono.h>
 #include <fmt/format.h>
 #include <fmt/std.h>
 
@@ -13,10 +14,44 @@ namespace leyval {
 // Money{3} is 3 cents
 // Money{500} is 5 dollars
 using Money = Fixed<-2>;
-const auto now = std::chrono::steady_clock::now;
-using time_point = std::chrono::time_point<std::chrono::steady_clock>;
 
-static const time_point INIT_TS{ now() };
+// Logical time, in the tick an order was accepted by an Exchange, then the
+// order it was accepted in during that tick.
+// Runs from the same seed get the same timestamps, unlike wall time.
+struct Timestamp
+{
+  std::uint32_t tick{ 0 };
+  std::uint32_t seq{ 0 };
+
+  auto operator<=>(const Timestamp&) const = default;
+};
+
+// Per-Exchange source of Timestamps
+class SimClock
+{
+public:
+  // Unique and increasing within a clock
+  Timestamp stamp() { return { m_tick, m_seq++ }; }
+
+  // Moves on to the next tick
+  void advance() { advance_to(m_tick + 1); }
+
+  // Moves on to tick, skipping any in between
+  void advance_to(std::uint32_t tick)
+  {
+    m_tick = tick;
+    m_seq = 0;
+  }
+
+  [[nodiscard]] std::uint32_t tick() const { return m_tick; }
+
+private:
+  std::uint32_t m_tick{ 0 };
+  std::uint32_t m_seq{ 0 };
+};
+
+// Assigned by OrderBook::insert, unique within a book
+using OrderId = std::uint64_t;
 
 enum class OrderDir
 {
@@ -45,6 +80,13 @@ struct fmt::formatter<leyval::OrderDir> : fmt::formatter<std::string_view>
               format_context& ctx) const -> format_context::iterator;
 };
 
+template<>
+struct fmt::formatter<leyval::Timestamp> : fmt::formatter<std::string_view>
+{
+  auto format(const leyval::Timestamp& ts,
+              format_context& ctx) const -> format_context::iterator;
+};
+
 ///////////////////
 namespace leyval {
 template<typename T>
@@ -52,7 +94,7 @@ concept IsOrderReq =
   std::three_way_comparable<T, std::strong_ordering> && requires(T a, T b) {
     { a.volume } -> std::same_as<int&>;
     { a.agent_id } -> std::same_as<int&>;
-    { a.timestamp } -> std::same_as<time_point&>;
+    { a.timestamp } -> std::same_as<Timestamp&>;
     { a.order_dir } -> std::same_as<OrderDir&>;
   };
 
@@ -65,7 +107,8 @@ struct MarketOrderReq
   int agent_id{};
   // An OrderDir::Bid MOR pops the best Ask LimitOrder.
   OrderDir order_dir{};
-  time_point timestamp{ now() };
+  // Stamped by the Exchange that accepts it
+  Timestamp timestamp{};
 };
 std::strong_ordering
 operator<=>(const MarketOrderReq& mor1, const MarketOrderReq& mor2);
@@ -87,7 +130,9 @@ struct LimitOrderVal
 {
   int volume{};
   int agent_id{};
-  time_point timestamp{ now() };
+  // Of the LimitOrderReq
+  Timestamp timestamp{};
+  OrderId order_id{};
 };
 std::strong_ordering
 operator<=>(const LimitOrderVal& lov1, const LimitOrderVal& lov2);
@@ -102,7 +147,8 @@ struct LimitOrderReq
   // Else is just a market order
   Money price;
   OrderDir order_dir{};
-  time_point timestamp{ now() };
+  // Stamped by the Exchange that accepts it
+  Timestamp timestamp{};
 
   [[nodiscard]] LimitOrder to_full() const
   {
@@ -135,8 +181,10 @@ struct CancelOrderReq
   int agent_id{};
   Money price;
   OrderDir order_dir{};
-  time_point lo_timestamp{};
-  time_point timestamp{ now() };
+  // Empty means cancel the agent's earliest order on order_dir
+  std::optional<OrderId> order_id{};
+  // Stamped by the Exchange that accepts it
+  Timestamp timestamp{};
 };
 
 std::strong_ordering
@@ -1,5 +1,4 @@
 #include <algorithm>
-#include <cassert>
 #include <map>
 
 #include "my_spdlog.hpp"
@@ -14,13 +13,15 @@ to_json(nlohmann::json& j, const OrderBook& order_book)
   std::map<Money, int> bid_counts;
   std::map<Money, int> ask_counts;
 
-  for (const auto& pair : order_book.m_bids) {
-    ++bid_counts[pair.first];
-  }
+  order_book.m_bids.for_each_level(
+    [&](Money price, const PriceLadder::Level& level) {
+      bid_counts[price] = level.size();
+    });
 
-  for (const auto& pair : order_book.m_asks) {
-    ++ask_counts[pair.first];
-  }
+  order_book.m_asks.for_each_level(
+    [&](Money price, const PriceLadder::Level& level) {
+      ask_counts[price] = level.size();
+    });
 
   j = nlohmann::json{ { "bid_counts", bid_counts },
                       { "ask_counts", ask_counts } };
@@ -51,86 +52,117 @@ OrderBook::current_best_price(OrderDir order_dir) const
     return 1;
   }
 
-  Money best_price{ 0 };
-  switch (order_dir) {
-    case OrderDir::Bid:
-      best_price = std::ranges::max_element(m_bids)->first;
-      break;
-    case OrderDir::Ask:
-      best_price = std::ranges::min_element(m_asks)->first;
-      break;
-    default:
-      throw OrderDirInvalidValue("OrderBook::current_best_price");
-  }
-  if (!(Money{ 0 } < best_price)) {
-    SPDLOG_ERROR(
-      "OrderBook::current_best_price: best_price must be greater than 0 ({})",
-      order_dir);
-    throw std::domain_error("");
-  }
+  // Any price the grid allows, so that the State never fails to follow a
+  // change the book has already made
+  return side(order_dir).best_price();
+}
 
-  return best_price;
+void
+OrderBook::update_state()
+{
+  State& state{ m_state };
+  state.best_price_bid = current_best_price(OrderDir::Bid);
+  state.best_price_ask = current_best_price(OrderDir::Ask);
+  state.mid_price = (state.best_price_ask + state.best_price_bid) / Money{ 2 };
+  state.abs_spread = state.best_price_ask - state.best_price_bid;
+  // Expressed in %.
+  // (x-y)/midpoint == 2(x-y)/(x+y)
+  const int pct{ 100 };
+  state.quoted_spread = Money{ 0 } < state.mid_price
+                          ? pct * static_cast<float>(state.abs_spread) /
+                              static_cast<float>(state.mid_price)
+                          : 0.0F;
+
+  state.num_orders_bid = m_bids.num_orders();
+  state.num_orders_ask = m_asks.num_orders();
+  state.volume_bid = m_bids.total_volume();
+  state.volume_ask = m_asks.total_volume();
+  const int num_orders{ state.num_orders_bid + state.num_orders_ask };
+  state.imbalance =
+    num_orders == 0 ? 0.0F
+                    : (state.num_orders_bid - state.num_orders_ask) /
+                        static_cast<float>(num_orders);
 }
 
-[[nodiscard]] Money
-OrderBook::mid_price() const
+OrderId
+OrderBook::insert(LimitOrderReq lor)
 {
-  const Money ask{ current_best_price(OrderDir::Ask) };
-  const Money bid{ current_best_price(OrderDir::Bid) };
-  return (ask + bid) / Money{ 2 };
+  LimitOrder limit_order{ lor.to_full() };
+  limit_order.second.order_id = m_next_order_id;
+  side(lor.order_dir).push_back(limit_order);
+  ++m_next_order_id;
+  update_state();
+  return limit_order.second.order_id;
 }
 
-[[nodiscard]] float
-OrderBook::quoted_spread() const
+PriceLadder::iterator
+OrderBook::remove_order(PriceLadder::iterator order_it, OrderDir order_dir)
 {
-  // Expressed in %.
-  // (x-y)/midpoint == 2(x-y)/(x+y)
-  const int pct{ 100 };
-  return pct * static_cast<float>(abs_spread() / mid_price());
+  const auto next{ side(order_dir).erase(order_it) };
+  update_state();
+  return next;
 }
 
-[[nodiscard]] Money
-OrderBook::abs_spread() const
+PriceLadder::iterator
+OrderBook::fill_order(PriceLadder::iterator order_it,
+                      OrderDir order_dir,
+                      int volume)
 {
-  const Money ask{ current_best_price(OrderDir::Ask) };
-  const Money bid{ current_best_price(OrderDir::Bid) };
-  return (ask - bid);
+  const auto next{ side(order_dir).fill(order_it, volume) };
+  update_state();
+  return next;
 }
 
-[[nodiscard]] int
-OrderBook::num_orders(OrderDir order_dir) const
+bool
+OrderBook::remove_earliest_order(int agent_id, OrderDir order_dir)
 {
-  switch (order_dir) {
-    case OrderDir::Bid:
-      return std::ssize(m_bids);
-    case OrderDir::Ask:
-      return std::ssize(m_asks);
-    default:
-      throw OrderDirInvalidValue("OrderBook::num_orders");
+  auto agent_orders{ orders_at_agentid(agent_id, order_dir) };
+  if (agent_orders.empty()) {
+    return false;
   }
+  side(order_dir).erase(agent_orders.begin());
+  update_state();
+  return true;
 }
 
-[[nodiscard]] float
-OrderBook::imbalance() const
+bool
+OrderBook::remove_specific_order(int agent_id,
+                                 OrderId order_id,
+                                 OrderDir order_dir)
 {
+  PriceLadder& ladder{ side(order_dir) };
+  const auto order_it{ ladder.find(order_id) };
+  if (order_it == ladder.end() || order_it->second.agent_id != agent_id) {
+    return false;
+  }
+  ladder.erase(order_it);
+  update_state();
+  return true;
+}
 
-  int bids {num_orders(OrderDir::Bid)};
-  int asks{num_orders(OrderDir::Ask)};
-  return (bids - asks) / static_cast<float>(bids + asks);
+PriceLadder&
+OrderBook::side(OrderDir order_dir)
+{
+  switch (order_dir) {
+    case OrderDir::Bid:
+      return m_bids;
+    case OrderDir::Ask:
+      return m_asks;
+    default:
+      throw OrderDirInvalidValue("OrderBook::side");
+  }
 }
 
-void
-OrderBook::insert(LimitOrderReq lor)
+const PriceLadder&
+OrderBook::side(OrderDir order_dir) const
 {
-  switch (lor.order_dir) {
+  switch (order_dir) {
     case OrderDir::Bid:
-      m_bids.insert(lor.to_full());
-      break;
+      return m_bids;
     case OrderDir::Ask:
-      m_asks.insert(lor.to_full());
-      break;
+      return m_asks;
     default:
-      throw OrderDirInvalidValue("OrderBook::insert");
+      throw OrderDirInvalidValue("OrderBook::side");
   }
 }
 }
@@ -1,190 +1,183 @@
 #pragma once
 
-#include <map>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <ranges>
 
 #include "order.hpp"
+#include "price_ladder.hpp"
 #include "serializable.hpp"
 
 namespace leyval {
+// Best N levels of each side of an OrderBook, best first.
+// Only the first num_levels_bid/ask entries are meaningful.
+template<std::size_t N>
+struct DepthSnapshot
+{
+  std::array<DepthLevel, N> bids{};
+  std::array<DepthLevel, N> asks{};
+  std::size_t num_levels_bid{ 0 };
+  std::size_t num_levels_ask{ 0 };
+
+  [[nodiscard]] std::span<const DepthLevel> bid_levels() const
+  {
+    return { bids.data(), num_levels_bid };
+  }
+  [[nodiscard]] std::span<const DepthLevel> ask_levels() const
+  {
+    return { asks.data(), num_levels_ask };
+  }
+};
+
 class OrderBook
 {
 public:
   OrderBook() = default;
+  // Resting orders must be priced on grid
+  explicit OrderBook(PriceGrid grid)
+    : m_bids{ OrderDir::Bid, grid }
+    , m_asks{ OrderDir::Ask, grid }
+  {
+  }
 
   // NOTE: Assume that any order is valid (i.e. agent has sufficient capital and
   // shares)
 
-  // TODO: Instead of a struct with separate implementation, each method could
-  // check some cache based on internal time stamp
+  // Kept current on every change to the book, so reading it is a copy.
+  // Until both sides have an order, best prices are taken to be 1.
+  // quoted_spread is 0 while mid_price is not positive.
   struct State
   {
-    Money best_price_bid;
-    Money best_price_ask;
-    Money mid_price;
-    float quoted_spread;
-    Money abs_spread;
-    int num_orders_bid;
-    int num_orders_ask;
-    float imbalance;
-
-    State(const OrderBook& ob)
-      : best_price_bid{ ob.current_best_price(OrderDir::Bid) }
-      , best_price_ask{ ob.current_best_price(OrderDir::Ask) }
-      // TODO: can reuse computed best_price_bid/ask
-      , mid_price{ ob.mid_price() }
-      , quoted_spread{ ob.quoted_spread() }
-      , abs_spread{ ob.abs_spread() }
-      , num_orders_bid{ ob.num_orders(OrderDir::Bid) }
-      , num_orders_ask{ ob.num_orders(OrderDir::Ask) }
-      // TODO: can reuse computed num_orders_bid/ask
-      , imbalance{ ob.imbalance() }
-    {
-    }
+    Money best_price_bid{ 1 };
+    Money best_price_ask{ 1 };
+    Money mid_price{ 1 };
+    float quoted_spread{ 0 };
+    Money abs_spread{ 0 };
+    int num_orders_bid{ 0 };
+    int num_orders_ask{ 0 };
+    std::int64_t volume_bid{ 0 };
+    std::int64_t volume_ask{ 0 };
+    // By number of orders, in [-1, 1]. 0 if the book is empty.
+    float imbalance{ 0 };
   };
 
-  [[nodiscard]] State update_get_state()
+  [[nodiscard]] const State& get_state() const { return m_state; }
+
+  // Levels keep their count and volume as orders change, so this only visits
+  // the best N levels of each side, and never walks individual orders.
+  template<std::size_t N>
+  [[nodiscard]] DepthSnapshot<N> depth() const
   {
-    m_state = State(*this);
-    return m_state;
+    DepthSnapshot<N> snapshot{};
+    snapshot.num_levels_bid = m_bids.top_levels(snapshot.bids);
+    snapshot.num_levels_ask = m_asks.top_levels(snapshot.asks);
+    return snapshot;
   }
 
-  // Returns pair of iterators to range of best-priced orders.
-  // These are able to mutate the underlying Bid/AskContainer.
-  // This is only used in FIFOMatchingSystem,
-  // (which runs for every MOR * every volume).
+  // Returns pair of iterators to range of best-priced orders, in time priority.
+  // These are able to mutate the underlying PriceLadder level.
+  // This is used in MatchingSystem, once per level swept by a MOR.
   auto orders_at_best_price(OrderDir order_dir)
   {
-    switch (order_dir) {
-      case OrderDir::Bid:
-        return m_bids.equal_range(m_state.best_price_bid);
-      case OrderDir::Ask:
-        return m_asks.equal_range(m_state.best_price_ask);
-      default:
-        throw OrderDirInvalidValue("OrderBook::orders_at_best_price");
-    }
+    PriceLadder& ladder{ side(order_dir) };
+    return std::pair{ ladder.begin(ladder.best_level()), ladder.end() };
   }
 
-  // NOTE: m_bids/bids are different types due to comparator,
-  // so combined function is impossible
-  auto orders_at_agentid_bid(int agent_id)
+  // Weights of the best level of order_dir, for drawing its resting orders at
+  // random. Kept up to date from the first call on. Only meaningful if
+  // !empty(order_dir).
+  PriceLadder::LevelWeights& best_level_weights(OrderDir order_dir)
   {
-    auto agent_eq = [&](const auto& e) {
-      return e.second.agent_id == agent_id;
-    };
-    return m_bids | std::ranges::views::filter(agent_eq);
+    return side(order_dir).best_level_weights();
   }
 
-  auto orders_at_agentid_ask(int agent_id) const
+  // Resting order of order_dir at a LevelWeights slot
+  PriceLadder::iterator order_at(OrderDir order_dir, PriceLadder::NodeIdx idx)
   {
-    auto agent_eq = [&](const auto& e) {
-      return e.second.agent_id == agent_id;
-    };
-    return m_asks | std::ranges::views::filter(agent_eq);
+    return side(order_dir).at(idx);
   }
 
-  void insert(LimitOrderReq lor);
+  // Every resting order of agent_id on one side of the book, earliest first.
+  auto orders_at_agentid(int agent_id, OrderDir order_dir)
+  {
+    return side(order_dir).orders_of(agent_id);
+  }
 
-  // order_it is iterator to m_bids/asks
-  // NOTE: I think this causes iterator invalidation
-  template<typename T>
-  T remove_order(T order_it, OrderDir order_dir)
+  auto orders_at_agentid_bid(int agent_id)
   {
-    switch (order_dir) {
-      case OrderDir::Bid:
-        return m_bids.erase(order_it);
-      case OrderDir::Ask:
-        return m_asks.erase(order_it);
-      default:
-        throw OrderDirInvalidValue("OrderBook::remove_order");
-    }
+    return orders_at_agentid(agent_id, OrderDir::Bid);
   }
 
-  // Returns:
-  //   true  <- earliest order successfully removed
-  //   false <- earliest order not found, thus nothing removed
-  bool remove_earliest_order(int agent_id, OrderDir order_dir)
+  auto orders_at_agentid_ask(int agent_id)
   {
-    switch (order_dir) {
-      case OrderDir::Bid: {
-        bool found{ false };
-        auto smallest{ m_bids.begin() };
-        for (auto iter{ smallest }; iter != m_bids.end(); ++iter) {
-          if ((iter->second.agent_id == agent_id) &&
-              (iter->second.timestamp <= smallest->second.timestamp)) {
-            found = true;
-            smallest = iter;
-          }
-        }
-        if (found) {
-          remove_order(smallest, order_dir);
-        }
-        return found;
-      }
-      case OrderDir::Ask: {
-        bool found{ false };
-        auto smallest{ m_asks.begin() };
-        for (auto iter{ smallest }; iter != m_asks.end(); ++iter) {
-          if ((iter->second.agent_id == agent_id) &&
-              (iter->second.timestamp <= smallest->second.timestamp)) {
-            found = true;
-            smallest = iter;
-          }
-        }
-        if (found) {
-          remove_order(smallest, order_dir);
-        }
-        return found;
-      }
-      default:
-        throw OrderDirInvalidValue("OrderBook::remove_earliest_order");
-    }
+    return orders_at_agentid(agent_id, OrderDir::Ask);
   }
 
-  auto remove_specific_order(int agent_id, time_point tp, OrderDir order_dir)
+  // Calls f(price, level) for every non-empty level of one side, from best to
+  // worst
+  template<typename F>
+  void for_each_level(OrderDir order_dir, F f) const
   {
-    switch (order_dir) {
-      case OrderDir::Bid: {
-        for (auto iter{ m_bids.begin() }; iter != m_bids.end(); ++iter) {
-          if ((iter->second.agent_id == agent_id) &&
-              (iter->second.timestamp == tp)) {
-            return remove_order(iter, order_dir);
-          }
-        }
-        return m_bids.end();
-      }
-      case OrderDir::Ask: {
-        for (auto iter{ m_asks.begin() }; iter != m_asks.end(); ++iter) {
-          if ((iter->second.agent_id == agent_id) &&
-              (iter->second.timestamp == tp)) {
-            return remove_order(iter, order_dir);
-          }
-        }
-        return m_asks.end();
-      }
-      default:
-        throw OrderDirInvalidValue("OrderBook::remove_specific_order");
-    }
+    side(order_dir).for_each_level(f);
   }
 
-private:
-  // NOTE std::greater means largest element is at beginning
-  // This is an attempt to push frequent values to front of iteration.
-  // (bid -> larger)
-  using BidContainer = std::multimap<Money, LimitOrderVal, std::greater<>>;
-  using AskContainer = std::multimap<Money, LimitOrderVal, std::less<>>;
+  // Returns the OrderId that the resting order can be cancelled with.
+  // Throws std::domain_error, leaving the book as it was, if lor.price is not
+  // on the grid.
+  OrderId insert(LimitOrderReq lor);
+
+  // Makes room for num_orders resting orders on each side
+  void reserve(std::size_t num_orders)
+  {
+    m_bids.reserve(num_orders);
+    m_asks.reserve(num_orders);
+  }
+
+  // order_it is iterator to a level of m_bids/asks
+  // NOTE: Only order_it is invalidated
+  PriceLadder::iterator remove_order(PriceLadder::iterator order_it,
+                                     OrderDir order_dir);
+
+  // Takes volume from the order at order_it, removing it once fully filled.
+  // Returns iterator to the next order to match against in the same level.
+  PriceLadder::iterator fill_order(PriceLadder::iterator order_it,
+                                   OrderDir order_dir,
+                                   int volume);
+
+  [[nodiscard]] const PriceGrid& grid() const { return m_bids.grid(); }
+
+  [[nodiscard]] bool empty(OrderDir order_dir) const
+  {
+    return side(order_dir).empty();
+  }
 
-  BidContainer m_bids;
-  AskContainer m_asks;
+  // Returns:
+  //   true  <- earliest order successfully removed
+  //   false <- earliest order not found, thus nothing removed
+  bool remove_earliest_order(int agent_id, OrderDir order_dir);
 
-  State m_state{ update_get_state() };
+  // Returns:
+  //   true  <- order successfully removed
+  //   false <- order not found (or owned by another agent), nothing removed
+  bool remove_specific_order(int agent_id,
+                             OrderId order_id,
+                             OrderDir order_dir);
 
+private:
+  PriceLadder m_bids{ OrderDir::Bid };
+  PriceLadder m_asks{ OrderDir::Ask };
+  OrderId m_next_order_id{ 0 };
+
+  State m_state{};
+
+  // Called after every change to m_bids/asks. Each side keeps its best price,
+  // number of orders and volume as it changes, so this is O(1).
+  void update_state();
   [[nodiscard]] Money current_best_price(OrderDir order_dir) const;
-  [[nodiscard]] Money mid_price() const;
-  [[nodiscard]] float quoted_spread() const;
-  [[nodiscard]] Money abs_spread() const;
-  [[nodiscard]] int num_orders(OrderDir order_dir) const;
-  [[nodiscard]] float imbalance() const;
+
+  PriceLadder& side(OrderDir order_dir);
+  [[nodiscard]] const PriceLadder& side(OrderDir order_dir) const;
 
   friend struct fmt::formatter<OrderBook>;
   friend void to_json(nlohmann::json& j, const OrderBook& order_book);
@@ -0,0 +1,17 @@
+#include <stdexcept>
+
+#include "population.hpp"
+
+namespace leyval {
+std::string_view
+agent_type_name(AgentType type)
+{
+  switch (type) {
+    case AgentType::jf_provider:
+      return JFProvider::name;
+    case AgentType::jf_taker:
+      return JFTaker::name;
+  }
+  throw std::domain_error("agent_type_name: invalid AgentType");
+}
+}
@@ -0,0 +1,372 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "my_spdlog.hpp"
+#include "serializable.hpp"
+
+#include "agent.hpp"
+#include "constants.hpp"
+#include "order.hpp"
+#include "order_book.hpp"
+#include "util/alias_table.hpp"
+
+namespace leyval {
+enum class AgentType : std::uint8_t
+{
+  jf_provider,
+  jf_taker,
+};
+
+std::string_view
+agent_type_name(AgentType type);
+
+// Decision kernels of the JF agents.
+// A Batch decides for any number of agents on the same OrderBook::State, so
+// what depends only on the state is worked out once, not once per agent.
+// Each agent draws from its own stream only, so batches over disjoint agents
+// may decide concurrently.
+struct JFProvider
+{
+  static constexpr AgentType type{ AgentType::jf_provider };
+  static constexpr std::string_view name{ "JFProvider" };
+
+  class Batch
+  {
+  public:
+    explicit Batch(const OrderBook::State& ob_state)
+      : m_ob_state{ ob_state }
+      , m_bid{ static_cast<float>(ob_state.num_orders_ask) /
+               static_cast<float>(ob_state.num_orders_bid +
+                                  ob_state.num_orders_ask) }
+      , m_wide_spread{ Money{ 150 } < ob_state.abs_spread }
+    {
+    }
+
+    template<class PRNG>
+    void decide(int id, PRNG& prng, std::vector<OrderReq_t>& reqs);
+
+  private:
+    // Offsets of a new limit order from the best price, away from the spread.
+    // While the spread is wide, weight inwards (negative).
+    static constexpr std::array<int, 6> wide_offsets{ -2, -1, 0, 1, 2, 3 };
+    static constexpr AliasTable wide_weights{ std::array<double, 6>{
+      3, 3, 4, 2, 2, 2 } };
+    static constexpr std::array<int, 7> narrow_offsets{ -1, 0, 1, 2, 3, 4, 5 };
+    static constexpr AliasTable narrow_weights{ std::array<double, 7>{
+      1, 3, 5, 4, 3, 2, 2 } };
+
+    const OrderBook::State& m_ob_state;
+    std::bernoulli_distribution m_place_order{ 0.75 };
+    std::bernoulli_distribution m_bid;
+    bool m_wide_spread;
+    // Built once per batch, as building one precomputes its sampling constants
+    std::poisson_distribution<> m_volume{ 15 };
+  };
+};
+
+struct JFTaker
+{
+  static constexpr AgentType type{ AgentType::jf_taker };
+  static constexpr std::string_view name{ "JFTaker" };
+
+  class Batch
+  {
+  public:
+    static constexpr double default_mean_volume{ 2 };
+
+    explicit Batch([[maybe_unused]] const OrderBook::State& ob_state,
+                   double mean_volume = default_mean_volume)
+      : m_volume{ mean_volume }
+    {
+    }
+
+    template<class PRNG>
+    void decide(int id, PRNG& prng, std::vector<OrderReq_t>& reqs);
+
+  private:
+    std::bernoulli_distribution m_place_order{ 0.5 };
+    std::bernoulli_distribution m_buy{ 0.5 };
+    std::poisson_distribution<> m_volume;
+  };
+};
+
+// Agents stored column-wise: one contiguous array per field, indexed by agent
+// id, instead of one heap object per agent.
+// An agent's id is its index, which is what orders and transactions carry, so
+// settling a transaction is two array updates.
+template<class PRNG>
+class Population
+{
+public:
+  // Seeds the new agent's stream from prng. The agent decides every
+  // mean_interval ticks on average, see next_decision. Returns its id.
+  int add(AgentType type,
+          Money capital,
+          PRNG& prng,
+          float mean_interval = 1);
+
+  void reserve(std::size_t n);
+
+  // Reorders the agents, so that types interleave in id order, which is the
+  // order an Exchange applies their requests in.
+  // Renumbers them, so only call before they have orders in a book.
+  void shuffle(PRNG& prng);
+
+  // Appends the requests for tick of the agents in ids to reqs, in the order
+  // of ids. Runs of agents of one type go through that type's kernel in one
+  // loop, so ids are best grouped by type.
+  // Safe to call concurrently on disjoint ids.
+  void generate_orders(const OrderBook::State& ob_state,
+                       std::uint32_t tick,
+                       std::span<const int> ids,
+                       std::vector<OrderReq_t>& reqs);
+
+  // Tick of the agent's next decision after tick. Gaps are geometric, the
+  // discrete time counterpart of exponential inter-arrival times, drawn from
+  // the agent's stream after its decision in tick. Agents with a
+  // mean_interval of 1 decide every tick, without a draw.
+  std::uint32_t next_decision(int id, std::uint32_t tick);
+
+  // Mean volume of the market orders of every JFTaker, which is Poisson
+  void set_mean_market_volume(double mean)
+  {
+    if (!(mean > 0)) {
+      throw std::invalid_argument(
+        "Population::set_mean_market_volume: mean <= 0");
+    }
+    m_mean_market_volume = mean;
+  }
+
+  void buy(int id, const int volume, const Money total_price)
+  {
+    m_shares[id] += volume;
+    m_capital[id] -= total_price;
+  }
+  void sell(int id, const int volume, const Money total_price)
+  {
+    m_shares[id] -= volume;
+    m_capital[id] += total_price;
+  }
+
+  [[nodiscard]] std::size_t size() const { return m_types.size(); }
+  [[nodiscard]] AgentType type(int id) const { return m_types[id]; }
+  [[nodiscard]] Money capital(int id) const { return m_capital[id]; }
+  [[nodiscard]] int shares(int id) const { return m_shares[id]; }
+
+private:
+  std::vector<AgentType> m_types;
+  std::vector<Money> m_capital;
+  std::vector<int> m_shares;
+  std::vector<float> m_mean_intervals;
+  // Each agent's own stream, see split_stream and seek_tick
+  std::vector<PRNG> m_prngs;
+  double m_mean_market_volume{ JFTaker::Batch::default_mean_volume };
+
+  friend inline void to_json(nlohmann::json& j, const Population& population)
+  {
+    j = nlohmann::json::array();
+    for (int id{ 0 }; id < static_cast<int>(population.size()); ++id) {
+      j.push_back({ { "id", id },
+                    { "capital", population.capital(id) },
+                    { "shares", population.shares(id) },
+                    { "type", agent_type_name(population.type(id)) } });
+    }
+    static_assert(Serializable<Population<PRNG>>);
+  }
+};
+
+// Population of the JF simulation: constants::n_providers JFProviders and
+// constants::n_takers JFTakers, in random order
+template<class PRNG>
+Population<PRNG>
+make_jf_agents(PRNG& prng)
+{
+  std::uniform_int_distribution<> capital(80'000, 120'000);
+  Population<PRNG> agents{};
+  agents.reserve(constants::n_providers + constants::n_takers);
+
+  for ([[maybe_unused]] const int _ :
+       std::views::iota(0, constants::n_providers)) {
+    agents.add(AgentType::jf_provider, capital(prng), prng);
+  }
+
+  for ([[maybe_unused]] const int _ :
+       std::views::iota(0, constants::n_takers)) {
+    agents.add(AgentType::jf_taker, capital(prng), prng);
+  }
+  // NOTE: may want to not shuffle when grouping in python
+  agents.shuffle(prng);
+  return agents;
+}
+}
+
+// Impls //////////////////////////////////////////////////////////////////////
+
+namespace leyval {
+template<class PRNG>
+void
+JFProvider::Batch::decide(int id, PRNG& prng, std::vector<OrderReq_t>& reqs)
+{
+  SPDLOG_TRACE("JFProvider::decide:: id: {}", id);
+
+  if (!m_place_order(prng)) {
+    return;
+  }
+  // Volumes of one agent must not depend on which agents shared its batch
+  m_volume.reset();
+
+  // TODO: Need a better way for agent to decide cancellation order_dir
+  // TODO: use orders_at_agentid to construct cor with an order_id
+  const OrderDir order_dir{ m_bid(prng) ? OrderDir::Bid : OrderDir::Ask };
+  auto limit_order{ [&]() {
+    const int volume{ m_volume(prng) };
+    const Money offset{ m_wide_spread
+                          ? wide_offsets[wide_weights(prng)]
+                          : narrow_offsets[narrow_weights(prng)] };
+    reqs.emplace_back(
+      LimitOrderReq{ .volume = volume,
+                     .agent_id = id,
+                     .price = order_dir == OrderDir::Bid
+                                ? m_ob_state.best_price_bid - offset
+                                : m_ob_state.best_price_ask + offset,
+                     .order_dir = order_dir });
+  } };
+
+  // Cancel earliest LO, then create new LO
+  reqs.emplace_back(CancelOrderReq{
+    .volume = 0, .agent_id = id, .price = 0, .order_dir = order_dir });
+  limit_order();
+  // Sometimes create another LO, to offset reduction from MO
+  if (m_bid(prng)) {
+    limit_order();
+  }
+}
+
+template<class PRNG>
+void
+JFTaker::Batch::decide(int id, PRNG& prng, std::vector<OrderReq_t>& reqs)
+{
+  SPDLOG_TRACE("JFTaker::decide:: id: {}", id);
+
+  if (!m_place_order(prng)) {
+    return;
+  }
+  m_volume.reset();
+  const OrderDir order_dir{ m_buy(prng) ? OrderDir::Bid : OrderDir::Ask };
+  reqs.emplace_back(MarketOrderReq{
+    .volume = m_volume(prng), .agent_id = id, .order_dir = order_dir });
+}
+
+template<class PRNG>
+int
+Population<PRNG>::add(AgentType type,
+                      Money capital,
+                      PRNG& prng,
+                      float mean_interval)
+{
+  if (!(mean_interval >= 1)) {
+    throw std::invalid_argument("Population::add: mean_interval < 1");
+  }
+  m_types.push_back(type);
+  m_capital.push_back(capital);
+  m_shares.push_back(0);
+  m_mean_intervals.push_back(mean_interval);
+  m_prngs.push_back(split_stream(prng));
+  return static_cast<int>(size()) - 1;
+}
+
+template<class PRNG>
+void
+Population<PRNG>::reserve(std::size_t n)
+{
+  m_types.reserve(n);
+  m_capital.reserve(n);
+  m_shares.reserve(n);
+  m_mean_intervals.reserve(n);
+  m_prngs.reserve(n);
+}
+
+template<class PRNG>
+void
+Population<PRNG>::shuffle(PRNG& prng)
+{
+  std::vector<std::size_t> order(size());
+  std::iota(order.begin(), order.end(), std::size_t{ 0 });
+  std::ranges::shuffle(order, prng);
+
+  auto permute{ [&order](auto& column) {
+    std::remove_reference_t<decltype(column)> permuted;
+    permuted.reserve(column.size());
+    for (const std::size_t i : order) {
+      permuted.push_back(std::move(column[i]));
+    }
+    column = std::move(permuted);
+  } };
+  permute(m_types);
+  permute(m_capital);
+  permute(m_shares);
+  permute(m_mean_intervals);
+  permute(m_prngs);
+}
+
+template<class PRNG>
+void
+Population<PRNG>::generate_orders(const OrderBook::State& ob_state,
+                                  std::uint32_t tick,
+                                  std::span<const int> ids,
+                                  std::vector<OrderReq_t>& reqs)
+{
+  JFProvider::Batch providers{ ob_state };
+  JFTaker::Batch takers{ ob_state, m_mean_market_volume };
+
+  auto run{ [&](auto& batch, std::size_t begin, std::size_t end) {
+    for (std::size_t i{ begin }; i < end; ++i) {
+      const int id{ ids[i] };
+      seek_tick(m_prngs[id], tick);
+      batch.decide(id, m_prngs[id], reqs);
+    }
+  } };
+
+  std::size_t begin{ 0 };
+  while (begin < ids.size()) {
+    const AgentType type{ m_types[ids[begin]] };
+    std::size_t end{ begin + 1 };
+    while (end < ids.size() && m_types[ids[end]] == type) {
+      ++end;
+    }
+    switch (type) {
+      case AgentType::jf_provider:
+        run(providers, begin, end);
+        break;
+      case AgentType::jf_taker:
+        run(takers, begin, end);
+        break;
+    }
+    begin = end;
+  }
+}
+
+template<class PRNG>
+std::uint32_t
+Population<PRNG>::next_decision(int id, std::uint32_t tick)
+{
+  const float mean_interval{ m_mean_intervals[id] };
+  if (mean_interval == 1) {
+    return tick + 1;
+  }
+  std::geometric_distribution<std::uint32_t> gap{ 1 / mean_interval };
+  return tick + 1 + gap(m_prngs[id]);
+}
+}
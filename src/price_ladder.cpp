@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <ranges>
+#include <stdexcept>
+
+#include "price_ladder.hpp"
+
+namespace leyval {
+PriceLadder::PriceLadder(OrderDir side, PriceGrid grid, int num_levels)
+  : m_side{ side }
+  , m_grid{ grid }
+  , m_levels(num_levels)
+{
+}
+
+int
+PriceLadder::grow_to(PriceTick tick)
+{
+  // The grid keeps every tick, and so m_base, within max_offset of 0, and
+  // levels are never grown past that
+  const int idx{ index_of(tick) };
+  const std::int64_t num_levels{ std::ssize(m_levels) };
+  const std::int64_t max_offset{ m_grid.max_offset() };
+
+  if (idx >= num_levels) {
+    m_levels.resize(std::min(std::max(2 * num_levels, std::int64_t{ idx } + 1),
+                             max_offset - m_base + 1));
+  } else if (idx < 0) {
+    // Prepend at least as many levels as already exist, to amortize the shift
+    const int extra{ static_cast<int>(std::min(
+      std::max(num_levels, -std::int64_t{ idx }), max_offset + m_base)) };
+    m_levels.insert(m_levels.begin(), extra, Level{});
+    m_base -= extra;
+    m_lo += extra;
+    m_hi += extra;
+    return idx + extra;
+  }
+  return idx;
+}
+
+PriceLadder::Level&
+PriceLadder::level(Money price)
+{
+  return m_levels.at(index_of(m_grid.to_tick(price)));
+}
+
+const PriceLadder::Level&
+PriceLadder::level(Money price) const
+{
+  return m_levels.at(index_of(m_grid.to_tick(price)));
+}
+
+PriceLadder::iterator
+PriceLadder::find(OrderId order_id)
+{
+  const NodeIdx* const idx{ m_order_index.find(order_id) };
+  return idx == nullptr ? end() : iterator{ this, *idx };
+}
+
+void
+PriceLadder::push_back(const LimitOrder& limit_order)
+{
+  const int agent_id{ limit_order.second.agent_id };
+  if (agent_id < 0) {
+    throw std::domain_error("PriceLadder::push_back: negative agent_id");
+  }
+  if (agent_id >= std::ssize(m_agents)) {
+    m_agents.resize(agent_id + 1);
+  }
+
+  const PriceTick tick{ m_grid.to_tick(limit_order.first) };
+  const int lvl_idx{ grow_to(tick) };
+  const NodeIdx idx{ alloc_node(limit_order, tick) };
+  // Before linking, as weigh_back may rebuild the slots from the queue
+  if (m_levels[lvl_idx].weights >= 0) {
+    weigh_back(lvl_idx, idx);
+  }
+  link_back<&Node::prev, &Node::next>(m_levels[lvl_idx], idx);
+  m_levels[lvl_idx].volume += limit_order.second.volume;
+  link_back<&Node::agent_prev, &Node::agent_next>(m_agents[agent_id], idx);
+  index_order(limit_order.second.order_id, idx);
+
+  if (empty()) {
+    m_lo = lvl_idx;
+    m_hi = lvl_idx;
+  } else {
+    m_lo = std::min(m_lo, lvl_idx);
+    m_hi = std::max(m_hi, lvl_idx);
+  }
+  ++m_num_orders;
+  m_total_volume += limit_order.second.volume;
+}
+
+PriceLadder::iterator
+PriceLadder::erase(iterator order_it)
+{
+  const NodeIdx idx{ order_it.node() };
+  const Node node{ m_nodes[idx] };
+  const int lvl_idx{ index_of(node.tick) };
+  Level& lvl{ m_levels[lvl_idx] };
+  if (lvl.weights >= 0) {
+    unweigh(lvl_idx, idx);
+  }
+
+  unlink<&Node::prev, &Node::next>(lvl, idx);
+  lvl.volume -= node.order.second.volume;
+  unlink<&Node::agent_prev, &Node::agent_next>(
+    m_agents[node.order.second.agent_id], idx);
+  unindex_order(node.order.second.order_id);
+  free_node(idx);
+  --m_num_orders;
+  m_total_volume -= node.order.second.volume;
+
+  if (lvl.empty()) {
+    shrink_range();
+  }
+  return { this, node.next };
+}
+
+PriceLadder::iterator
+PriceLadder::fill(iterator order_it, int volume)
+{
+  assert(0 <= volume && volume <= order_it->second.volume &&
+         "fill volume must be within resting volume");
+  const Node& node{ m_nodes[order_it.node()] };
+  Level& lvl{ m_levels[index_of(node.tick)] };
+  order_it->second.volume -= volume;
+  lvl.volume -= volume;
+  if (lvl.weights >= 0) {
+    m_weights[lvl.weights].volume.add(node.slot, -volume);
+  }
+  m_total_volume -= volume;
+  if (order_it->second.volume == 0) {
+    return erase(order_it);
+  }
+  return order_it;
+}
+
+std::size_t
+PriceLadder::top_levels(std::span<DepthLevel> out) const
+{
+  if (empty()) {
+    return 0;
+  }
+  // Towards worse prices from the best level, only over the occupied range
+  const int step{ m_side == OrderDir::Bid ? -1 : 1 };
+  const int last{ m_side == OrderDir::Bid ? m_lo - 1 : m_hi + 1 };
+
+  std::size_t n{ 0 };
+  std::int64_t cumulative_volume{ 0 };
+  for (int i{ best_index() }; i != last && n < out.size(); i += step) {
+    const Level& lvl{ m_levels[i] };
+    if (lvl.empty()) {
+      continue;
+    }
+    cumulative_volume += lvl.volume;
+    out[n++] = DepthLevel{ .price = price_of(i),
+                           .num_orders = lvl.size(),
+                           .volume = lvl.volume,
+                           .cumulative_volume = cumulative_volume };
+  }
+  return n;
+}
+
+PriceLadder::LevelWeights&
+PriceLadder::best_level_weights()
+{
+  Level& lvl{ best_level() };
+  if (lvl.weights < 0) {
+    if (m_free_weights.empty()) {
+      lvl.weights = static_cast<int>(m_weights.size());
+      m_weights.emplace_back();
+    } else {
+      lvl.weights = m_free_weights.back();
+      m_free_weights.pop_back();
+    }
+    compact_weights(best_index());
+  }
+  return m_weights[lvl.weights];
+}
+
+void
+PriceLadder::weigh_back(int lvl_idx, NodeIdx idx)
+{
+  LevelWeights& weights{ m_weights[m_levels[lvl_idx].weights] };
+  // Amortized against the erases that made the dead slots
+  if (2 * weights.num_erased > std::ssize(weights.slots)) {
+    compact_weights(lvl_idx);
+  }
+  const int volume{ m_nodes[idx].order.second.volume };
+  m_nodes[idx].slot = static_cast<int>(weights.slots.size());
+  weights.slots.push_back(idx);
+  weights.volume.push_back(volume);
+  weights.count.push_back(volume > 0);
+}
+
+void
+PriceLadder::unweigh(int lvl_idx, NodeIdx idx)
+{
+  Level& lvl{ m_levels[lvl_idx] };
+  LevelWeights& weights{ m_weights[lvl.weights] };
+  const int slot{ m_nodes[idx].slot };
+  if (lvl.size() == 1) {
+    // Last order of the level, which gives its LevelWeights back
+    weights.slots.clear();
+    weights.volume.clear();
+    weights.count.clear();
+    weights.num_erased = 0;
+    m_free_weights.push_back(lvl.weights);
+    lvl.weights = -1;
+    return;
+  }
+  weights.volume.add(slot, -weights.volume.value(slot));
+  weights.count.add(slot, -weights.count.value(slot));
+  weights.slots[slot] = null_node;
+  ++weights.num_erased;
+}
+
+void
+PriceLadder::compact_weights(int lvl_idx)
+{
+  LevelWeights& weights{ m_weights[m_levels[lvl_idx].weights] };
+  weights.slots.clear();
+  for (NodeIdx idx{ m_levels[lvl_idx].head }; idx != null_node;
+       idx = m_nodes[idx].next) {
+    m_nodes[idx].slot = static_cast<int>(weights.slots.size());
+    weights.slots.push_back(idx);
+  }
+  auto volume_of{ [this](NodeIdx idx) {
+    return std::int64_t{ m_nodes[idx].order.second.volume };
+  } };
+  weights.volume.assign(weights.slots | std::views::transform(volume_of));
+  weights.count.assign(weights.slots | std::views::transform([&](NodeIdx idx) {
+                         return std::int64_t{ volume_of(idx) > 0 };
+                       }));
+  weights.num_erased = 0;
+}
+
+void
+PriceLadder::shrink_range()
+{
+  if (empty()) {
+    return;
+  }
+  while (m_levels[m_lo].empty()) {
+    ++m_lo;
+  }
+  while (m_levels[m_hi].empty()) {
+    --m_hi;
+  }
+}
+
+PriceLadder::NodeIdx
+PriceLadder::alloc_node(const LimitOrder& limit_order, PriceTick tick)
+{
+  if (m_free == null_node) {
+    m_nodes.push_back(Node{ .order = limit_order, .tick = tick });
+    return static_cast<NodeIdx>(m_nodes.size() - 1);
+  }
+  const NodeIdx idx{ m_free };
+  m_free = m_nodes[idx].next;
+  m_nodes[idx] = Node{ .order = limit_order, .tick = tick };
+  return idx;
+}
+
+void
+PriceLadder::free_node(NodeIdx idx)
+{
+  m_nodes[idx].next = m_free;
+  m_free = idx;
+}
+
+void
+PriceLadder::index_order(OrderId order_id, NodeIdx idx)
+{
+  m_order_index.insert(order_id, idx);
+}
+
+void
+PriceLadder::unindex_order(OrderId order_id)
+{
+  [[maybe_unused]] const bool erased{ m_order_index.erase(order_id) };
+  assert(erased);
+}
+
+template<PriceLadder::NodeIdx PriceLadder::Node::*Prev,
+         PriceLadder::NodeIdx PriceLadder::Node::*Next>
+void
+PriceLadder::link_back(Queue& queue, NodeIdx idx)
+{
+  Node& node{ m_nodes[idx] };
+  node.*Prev = queue.tail;
+  node.*Next = null_node;
+  if (queue.tail == null_node) {
+    queue.head = idx;
+  } else {
+    m_nodes[queue.tail].*Next = idx;
+  }
+  queue.tail = idx;
+  ++queue.count;
+}
+
+template<PriceLadder::NodeIdx PriceLadder::Node::*Prev,
+         PriceLadder::NodeIdx PriceLadder::Node::*Next>
+void
+PriceLadder::unlink(Queue& queue, NodeIdx idx)
+{
+  const Node& node{ m_nodes[idx] };
+  if (node.*Prev == null_node) {
+    queue.head = node.*Next;
+  } else {
+    m_nodes[node.*Prev].*Next = node.*Next;
+  }
+  if (node.*Next == null_node) {
+    queue.tail = node.*Prev;
+  } else {
+    m_nodes[node.*Next].*Prev = node.*Prev;
+  }
+  --queue.count;
+}
+}
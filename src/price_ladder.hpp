@@ -0,0 +1,302 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "constants.hpp"
+#include "order.hpp"
+#include "price_tick.hpp"
+#include "util/fenwick_tree.hpp"
+#include "util/id_map.hpp"
+
+namespace leyval {
+// Aggregate of one price level
+struct DepthLevel
+{
+  Money price{ 0 };
+  int num_orders{ 0 };
+  std::int64_t volume{ 0 };
+  // Volume of this level and every better one
+  std::int64_t cumulative_volume{ 0 };
+};
+
+// One side of the OrderBook.
+// A contiguous ladder of price levels, where the level at index i holds every
+// resting LimitOrder at PriceTick{ m_base + i } of the ladder's PriceGrid.
+// Each level is a FIFO queue, so the earliest order at a price is always at
+// the front.
+//
+// Orders live in a node pool, and are intrusively linked into both their price
+// level and the queue of their agent. Together with an OrderId index, this
+// makes cancels and per-agent lookups O(1).
+class PriceLadder
+{
+public:
+  using NodeIdx = int;
+  static constexpr NodeIdx null_node{ -1 };
+
+  struct Node
+  {
+    LimitOrder order;
+    // Of order.first, so erasing and filling index levels directly
+    PriceTick tick;
+    // Into LevelWeights::slots, if they are kept
+    int slot{ -1 };
+    NodeIdx prev{ null_node };
+    NodeIdx next{ null_node };
+    NodeIdx agent_prev{ null_node };
+    NodeIdx agent_next{ null_node };
+  };
+
+  // Doubly linked list of nodes, in time priority
+  struct Queue
+  {
+    NodeIdx head{ null_node };
+    NodeIdx tail{ null_node };
+    int count{ 0 };
+
+    [[nodiscard]] bool empty() const { return count == 0; }
+    [[nodiscard]] int size() const { return count; }
+  };
+
+  struct Level : Queue
+  {
+    // Sum of resting volume in the queue
+    std::int64_t volume{ 0 };
+    // Into m_weights, while the level keeps LevelWeights
+    int weights{ -1 };
+  };
+
+  // Resting orders of one level, in time priority, weighted for drawing one
+  // at random. Erased orders keep their slot with no weight until the next
+  // order is appended to the level, so slots stay put while a market order
+  // fills the level.
+  struct LevelWeights
+  {
+    // null_node once erased
+    std::vector<NodeIdx> slots;
+    // Remaining volume of each order
+    FenwickTree<std::int64_t> volume;
+    // 1 for each order with volume left
+    FenwickTree<std::int64_t> count;
+    int num_erased{ 0 };
+  };
+
+  // Walks a Queue by following Next
+  template<NodeIdx Node::*Next>
+  class basic_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = LimitOrder;
+    using difference_type = std::ptrdiff_t;
+    using pointer = LimitOrder*;
+    using reference = LimitOrder&;
+
+    basic_iterator() = default;
+    basic_iterator(PriceLadder* ladder, NodeIdx idx)
+      : m_ladder{ ladder }
+      , m_idx{ idx }
+    {
+    }
+
+    reference operator*() const { return m_ladder->m_nodes[m_idx].order; }
+    pointer operator->() const { return &**this; }
+
+    basic_iterator& operator++()
+    {
+      m_idx = m_ladder->m_nodes[m_idx].*Next;
+      return *this;
+    }
+    basic_iterator operator++(int)
+    {
+      basic_iterator tmp{ *this };
+      ++*this;
+      return tmp;
+    }
+
+    bool operator==(const basic_iterator& other) const
+    {
+      return m_idx == other.m_idx;
+    }
+
+    [[nodiscard]] NodeIdx node() const { return m_idx; }
+
+  private:
+    PriceLadder* m_ladder{ nullptr };
+    NodeIdx m_idx{ null_node };
+  };
+
+  // Over a price level
+  using iterator = basic_iterator<&Node::next>;
+  // Over the orders of a single agent
+  using agent_iterator = basic_iterator<&Node::agent_next>;
+
+  // Default ladder covers ticks [0, 2 * price_center) of grid, and grows (in
+  // either direction, up to grid.max_offset()) if a price beyond that is
+  // inserted.
+  explicit PriceLadder(
+    OrderDir side,
+    PriceGrid grid = {},
+    int num_levels = 2 * constants::saturate::price_center);
+
+  // limit_order.second.order_id must be unique within this ladder.
+  // Throws std::domain_error if limit_order.first is not on the grid.
+  void push_back(const LimitOrder& limit_order);
+
+  // Makes room for num_orders resting orders, so that push_back does not
+  // allocate until there are more
+  void reserve(std::size_t num_orders)
+  {
+    m_nodes.reserve(num_orders);
+    m_order_index.reserve(num_orders);
+  }
+
+  // Returns iterator to the next order in the same level.
+  iterator erase(iterator order_it);
+  iterator erase(agent_iterator order_it)
+  {
+    return erase(iterator{ this, order_it.node() });
+  }
+
+  // Takes volume from the order at order_it, erasing it once fully filled.
+  // Returns iterator to the next order if erased, otherwise order_it.
+  // Resting volume must only be changed through here, to keep total_volume().
+  iterator fill(iterator order_it, int volume);
+
+  [[nodiscard]] iterator begin(const Level& level)
+  {
+    return { this, level.head };
+  }
+  [[nodiscard]] iterator end() { return { this, null_node }; }
+
+  // Throw if price is not on the grid, or not covered by the ladder
+  [[nodiscard]] Level& level(Money price);
+  [[nodiscard]] const Level& level(Money price) const;
+  [[nodiscard]] Level& best_level() { return m_levels[best_index()]; }
+
+  // A level keeps LevelWeights from the first call on it until it empties,
+  // so that levels that are never drawn from do not pay for them
+  [[nodiscard]] LevelWeights& best_level_weights();
+
+  [[nodiscard]] iterator at(NodeIdx idx) { return { this, idx }; }
+
+  // Best is the highest price for Bids, and lowest price for Asks.
+  // Only meaningful if !empty()
+  [[nodiscard]] Money best_price() const { return price_of(best_index()); }
+
+  [[nodiscard]] const PriceGrid& grid() const { return m_grid; }
+
+  [[nodiscard]] bool empty() const { return m_num_orders == 0; }
+  [[nodiscard]] int num_orders() const { return m_num_orders; }
+  // Sum of resting volume over every level
+  [[nodiscard]] std::int64_t total_volume() const { return m_total_volume; }
+
+  // Returns end() if order_id is not resting in this ladder
+  [[nodiscard]] iterator find(OrderId order_id);
+
+  // Orders of agent_id, earliest first
+  [[nodiscard]] auto orders_of(int agent_id)
+  {
+    const NodeIdx head{ (0 <= agent_id && agent_id < std::ssize(m_agents))
+                          ? m_agents[agent_id].head
+                          : null_node };
+    return std::ranges::subrange(agent_iterator{ this, head },
+                                 agent_iterator{ this, null_node });
+  }
+
+  // Writes the best out.size() non-empty levels into out, best first.
+  // Returns the number written, fewer if there are not enough levels.
+  std::size_t top_levels(std::span<DepthLevel> out) const;
+
+  // Calls f(price, level) for every non-empty level, from best to worst.
+  template<typename F>
+  void for_each_level(F f) const
+  {
+    if (empty()) {
+      return;
+    }
+    switch (m_side) {
+      case OrderDir::Bid:
+        for (int i{ m_hi }; i >= m_lo; --i) {
+          if (!m_levels[i].empty()) {
+            f(price_of(i), m_levels[i]);
+          }
+        }
+        break;
+      case OrderDir::Ask:
+        for (int i{ m_lo }; i <= m_hi; ++i) {
+          if (!m_levels[i].empty()) {
+            f(price_of(i), m_levels[i]);
+          }
+        }
+        break;
+      default:
+        throw OrderDirInvalidValue("PriceLadder::for_each_level");
+    }
+  }
+
+private:
+  OrderDir m_side;
+  PriceGrid m_grid;
+  std::vector<Level> m_levels;
+  // Pool of the LevelWeights of levels, reused once a level empties
+  std::vector<LevelWeights> m_weights;
+  std::vector<int> m_free_weights;
+  // PriceTick offset of m_levels[0]
+  int m_base{ 0 };
+  int m_num_orders{ 0 };
+  std::int64_t m_total_volume{ 0 };
+  // Range of occupied levels [m_lo, m_hi], only meaningful if !empty()
+  int m_lo{ 0 };
+  int m_hi{ 0 };
+
+  std::vector<Node> m_nodes;
+  // Singly linked through Node::next
+  NodeIdx m_free{ null_node };
+  // Indexed by agent_id
+  std::vector<Queue> m_agents;
+  // Of resting orders only, so it stays the size of the book however long
+  // an order rests while others come and go
+  IdMap<NodeIdx> m_order_index;
+
+  [[nodiscard]] int best_index() const
+  {
+    return m_side == OrderDir::Bid ? m_hi : m_lo;
+  }
+  [[nodiscard]] int index_of(PriceTick tick) const
+  {
+    return tick.offset - m_base;
+  }
+  [[nodiscard]] Money price_of(int idx) const
+  {
+    return m_grid.to_money({ m_base + idx });
+  }
+  // Returns index of tick, growing the ladder if tick is not yet covered
+  int grow_to(PriceTick tick);
+  void shrink_range();
+
+  NodeIdx alloc_node(const LimitOrder& limit_order, PriceTick tick);
+
+  // idx must not be linked into the level yet
+  void weigh_back(int lvl_idx, NodeIdx idx);
+  void unweigh(int lvl_idx, NodeIdx idx);
+  // Rebuilds the slots of a level from its queue, dropping erased ones
+  void compact_weights(int lvl_idx);
+  void free_node(NodeIdx idx);
+
+  void index_order(OrderId order_id, NodeIdx idx);
+  void unindex_order(OrderId order_id);
+
+  template<NodeIdx Node::*Prev, NodeIdx Node::*Next>
+  void link_back(Queue& queue, NodeIdx idx);
+  template<NodeIdx Node::*Prev, NodeIdx Node::*Next>
+  void unlink(Queue& queue, NodeIdx idx);
+};
+}
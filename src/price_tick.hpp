@@ -0,0 +1,91 @@
+#pragma once
+
+#include <compare>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+#include "order.hpp"
+
+namespace leyval {
+// Whole number of ticks from the reference price of a PriceGrid
+struct PriceTick
+{
+  std::int32_t offset{ 0 };
+
+  auto operator<=>(const PriceTick&) const = default;
+};
+
+// Prices an OrderBook can hold, reference_price + offset * tick_size for every
+// PriceTick offset within max_offset of 0. Prices are checked against the grid
+// once, where they enter the book, so that levels, depth and matching index
+// arrays by PriceTick with no further checks. As a ladder never spans more
+// than the grid, max_offset also bounds its memory.
+class PriceGrid
+{
+public:
+  // About $10,000 either side of the reference price in cents
+  static constexpr std::int32_t default_max_offset{ 1 << 20 };
+  // So that the distance between any two ticks fits in an int
+  static constexpr std::int32_t largest_max_offset{
+    std::numeric_limits<std::int32_t>::max() / 2
+  };
+
+  // Every whole cent, counted from 0
+  constexpr PriceGrid() = default;
+
+  constexpr PriceGrid(Money reference_price,
+                      Money tick_size,
+                      std::int32_t max_offset = default_max_offset)
+    : m_reference_price{ reference_price }
+    , m_tick_size{ tick_size }
+    , m_max_offset{ max_offset }
+  {
+    if (!(Money{ 0 } < tick_size)) {
+      throw std::invalid_argument("PriceGrid: tick_size must be positive");
+    }
+    if (max_offset < 0 || largest_max_offset < max_offset) {
+      throw std::invalid_argument(
+        "PriceGrid: max_offset must be in [0, largest_max_offset]");
+    }
+  }
+
+  // Throws std::domain_error if price is off the grid, or more than
+  // max_offset ticks from the reference price
+  [[nodiscard]] constexpr PriceTick to_tick(Money price) const
+  {
+    const std::int64_t diff{ price.underlying_value -
+                             m_reference_price.underlying_value };
+    const std::int64_t ticks{ diff / m_tick_size.underlying_value };
+    if (ticks * m_tick_size.underlying_value != diff) {
+      throw std::domain_error("PriceGrid::to_tick: price is between ticks");
+    }
+    if (ticks < -m_max_offset || m_max_offset < ticks) {
+      throw std::domain_error("PriceGrid::to_tick: price is out of range");
+    }
+    return { static_cast<std::int32_t>(ticks) };
+  }
+
+  [[nodiscard]] constexpr Money to_money(PriceTick tick) const
+  {
+    return m_reference_price + m_tick_size * tick.offset;
+  }
+
+  [[nodiscard]] constexpr Money reference_price() const
+  {
+    return m_reference_price;
+  }
+  [[nodiscard]] constexpr Money tick_size() const { return m_tick_size; }
+  [[nodiscard]] constexpr std::int32_t max_offset() const
+  {
+    return m_max_offset;
+  }
+
+  constexpr bool operator==(const PriceGrid&) const = default;
+
+private:
+  Money m_reference_price{ 0 };
+  Money m_tick_size{ 1 };
+  std::int32_t m_max_offset{ default_max_offset };
+};
+}
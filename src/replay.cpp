@@ -0,0 +1,63 @@
+#include <stdexcept>
+
+#include "replay.hpp"
+
+namespace {
+template<leyval::MatchingPolicy Policy>
+std::vector<leyval::event_log::Event>
+replay_with(Policy policy, std::span<const leyval::OrderReq_t> order_reqs)
+{
+  leyval::Replayer<Policy> replayer{ leyval::MatchingSystem{
+    std::move(policy) } };
+  replayer.apply(order_reqs);
+  return replayer.events();
+}
+}
+
+namespace leyval {
+std::vector<OrderReq_t>
+recorded_requests(const EventLogReader& log)
+{
+  std::vector<OrderReq_t> order_reqs;
+  order_reqs.reserve(log.size());
+  for (const event_log::Event& event : log) {
+    if (auto order_req{ event_log::to_order_request(event) }) {
+      order_reqs.push_back(*order_req);
+    }
+  }
+  return order_reqs;
+}
+
+std::vector<event_log::Event>
+replay(const MatchingConfig& config, std::span<const OrderReq_t> order_reqs)
+{
+  switch (config.type) {
+    case MatchingType::fifo:
+      return replay_with(FifoMatching{}, order_reqs);
+    case MatchingType::pro_rata:
+      return replay_with(ProRataMatching{}, order_reqs);
+    case MatchingType::random_selection:
+      return replay_with(
+        RandomSelectionMatching{ config.rss_weight, config.rss_seed },
+        order_reqs);
+  }
+  throw std::domain_error("replay: invalid MatchingType");
+}
+
+std::optional<std::size_t>
+first_divergence(const EventLogReader& log,
+                 std::span<const event_log::Event> events)
+{
+  std::size_t i{ 0 };
+  for (const event_log::Event& recorded : log) {
+    if (i == events.size() || recorded != events[i]) {
+      return i;
+    }
+    ++i;
+  }
+  if (i != events.size()) {
+    return i;
+  }
+  return std::nullopt;
+}
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "event_log.hpp"
+#include "matching_system.hpp"
+#include "order.hpp"
+#include "order_book.hpp"
+#include "overloaded.hpp"
+
+namespace leyval {
+// Feeds recorded order requests through an OrderBook and MatchingSystem,
+// without agents.
+// Journals the same events an Exchange does, so replaying a log under the
+// policy (and RSS seed) it was recorded with reproduces it exactly.
+template<MatchingPolicy Policy>
+class Replayer
+{
+public:
+  explicit Replayer(
+    MatchingSystem<Policy> matching_sys = MatchingSystem<Policy>{},
+    OrderBook order_book = OrderBook{})
+    : m_order_book{ std::move(order_book) }
+    , m_matching_sys{ std::move(matching_sys) }
+  {
+  }
+
+  // Handled as in Exchange::run
+  void apply(const OrderReq_t& order_req);
+
+  void apply(std::span<const OrderReq_t> order_reqs)
+  {
+    for (const OrderReq_t& order_req : order_reqs) {
+      apply(order_req);
+    }
+  }
+
+  [[nodiscard]] const std::vector<event_log::Event>& events() const
+  {
+    return m_events;
+  }
+  [[nodiscard]] const OrderBook& get_order_book() const { return m_order_book; }
+
+private:
+  OrderBook m_order_book;
+  MatchingSystem<Policy> m_matching_sys;
+  std::vector<event_log::Event> m_events;
+};
+
+static_assert(
+  std::is_default_constructible_v<Replayer<RandomSelectionMatching>>);
+
+// The requests of a log, in order, without its fills
+std::vector<OrderReq_t>
+recorded_requests(const EventLogReader& log);
+
+// Replays order_reqs from an empty book under the MatchingPolicy of config.
+// Returns the events journaled along the way.
+std::vector<event_log::Event>
+replay(const MatchingConfig& config, std::span<const OrderReq_t> order_reqs);
+
+// Index of the first event where log and events differ, including either
+// running out first. Empty if they are identical.
+std::optional<std::size_t>
+first_divergence(const EventLogReader& log,
+                 std::span<const event_log::Event> events);
+
+// Impls //////////////////////////////////////////////////////////////////////
+
+template<MatchingPolicy Policy>
+void
+Replayer<Policy>::apply(const OrderReq_t& order_req)
+{
+  std::visit(
+    overloaded{
+      [this](const LimitOrderReq& lor) {
+        const OrderId order_id{ m_order_book.insert(lor) };
+        m_events.push_back(event_log::limit_order_event(lor, order_id));
+      },
+      [this](const MarketOrderReq& mor) {
+        m_events.push_back(event_log::market_order_event(mor));
+        if (mor.volume <= 0) {
+          return;
+        }
+        for (const auto& trans : m_matching_sys(mor, m_order_book)) {
+          m_events.push_back(event_log::fill_event(mor, trans));
+        }
+      },
+      [this](const CancelOrderReq& cor) {
+        m_events.push_back(event_log::cancel_order_event(cor));
+        if (cor.order_id) {
+          m_order_book.remove_specific_order(
+            cor.agent_id, *cor.order_id, cor.order_dir);
+        } else {
+          m_order_book.remove_earliest_order(cor.agent_id, cor.order_dir);
+        }
+      } },
+    order_req);
+}
+}
@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#include "snapshot.hpp"
+
+static_assert(std::endian::native == std::endian::little,
+              "snapshot streams are written in native byte order");
+static_assert(sizeof(int) == sizeof(std::int32_t));
+
+namespace {
+// Grows buffer and copies into the new tail. Written out rather than with
+// vector::insert, which GCC 12 flags with a spurious -Warray-bounds at -O2.
+void
+append_bytes(std::vector<char>& buffer, const void* bytes, std::size_t size)
+{
+  if (size == 0) {
+    return;
+  }
+  const std::size_t offset{ buffer.size() };
+  buffer.resize(offset + size);
+  std::memcpy(buffer.data() + offset, bytes, size);
+}
+
+template<typename T>
+void
+append(std::vector<char>& buffer, const T& value)
+{
+  append_bytes(buffer, &value, sizeof(T));
+}
+
+template<typename T>
+void
+append_column(std::vector<char>& buffer, const std::vector<T>& column)
+{
+  append_bytes(buffer, column.data(), column.size() * sizeof(T));
+}
+
+void
+append_levels(std::vector<char>& buffer,
+              const std::vector<leyval::snapshot::Level>& levels)
+{
+  append(buffer, static_cast<std::uint32_t>(levels.size()));
+  for (const auto& level : levels) {
+    append(buffer, level.price);
+  }
+  for (const auto& level : levels) {
+    append(buffer, static_cast<std::int32_t>(level.num_orders));
+  }
+}
+
+// Reads from a record payload, throwing if it is shorter than expected
+class PayloadCursor
+{
+public:
+  explicit PayloadCursor(const std::vector<char>& payload)
+    : m_payload{ payload }
+  {
+  }
+
+  template<typename T>
+  T read()
+  {
+    T value;
+    std::memcpy(&value, take(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  template<typename T>
+  void read_column(std::vector<T>& column, std::size_t n)
+  {
+    column.resize(n);
+    std::memcpy(column.data(), take(n * sizeof(T)), n * sizeof(T));
+  }
+
+  void read_levels(std::vector<leyval::snapshot::Level>& levels)
+  {
+    levels.resize(read<std::uint32_t>());
+    for (auto& level : levels) {
+      level.price = read<std::int64_t>();
+    }
+    for (auto& level : levels) {
+      level.num_orders = read<std::int32_t>();
+    }
+  }
+
+private:
+  const std::vector<char>& m_payload;
+  std::size_t m_pos{ 0 };
+
+  const char* take(std::size_t n)
+  {
+    if (m_payload.size() - m_pos < n) {
+      throw std::runtime_error("SnapshotReader: malformed record");
+    }
+    const char* p{ m_payload.data() + m_pos };
+    m_pos += n;
+    return p;
+  }
+};
+
+template<typename T>
+bool
+read_value(std::ifstream& in, T& value)
+{
+  return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+}
+
+namespace leyval {
+SnapshotWriter::SnapshotWriter(const std::filesystem::path& path)
+  : m_out{ path, std::ios::binary | std::ios::trunc }
+{
+  if (!m_out) {
+    throw std::runtime_error("SnapshotWriter: cannot open " + path.string());
+  }
+}
+
+void
+SnapshotWriter::write_header(const std::vector<snapshot::AgentInfo>& agents)
+{
+  m_buffer.clear();
+  append_bytes(m_buffer, snapshot::magic, sizeof(snapshot::magic));
+  append(m_buffer, snapshot::version);
+  append(m_buffer, static_cast<std::uint32_t>(agents.size()));
+  for (const auto& agent : agents) {
+    append(m_buffer, static_cast<std::int32_t>(agent.id));
+    append(m_buffer, static_cast<std::uint16_t>(agent.type.size()));
+    append_bytes(m_buffer, agent.type.data(), agent.type.size());
+  }
+  m_out.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+  m_out.flush();
+
+  m_num_agents = agents.size();
+  m_header_written = true;
+}
+
+void
+SnapshotWriter::write_tick()
+{
+  if (m_tick.capital.size() != m_num_agents) {
+    throw std::logic_error("SnapshotWriter: agents changed after header");
+  }
+
+  m_buffer.clear();
+  // payload_len, filled in below
+  append(m_buffer, std::uint32_t{ 0 });
+  append(m_buffer, m_tick.tick);
+  append_column(m_buffer, m_tick.capital);
+  append_column(m_buffer, m_tick.shares);
+  append_levels(m_buffer, m_tick.bids);
+  append_levels(m_buffer, m_tick.asks);
+
+  const auto payload_len{ static_cast<std::uint32_t>(
+    m_buffer.size() - sizeof(std::uint32_t)) };
+  std::memcpy(m_buffer.data(), &payload_len, sizeof(payload_len));
+
+  m_out.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+  m_out.flush();
+}
+
+SnapshotReader::SnapshotReader(const std::filesystem::path& path)
+  : m_in{ path, std::ios::binary }
+{
+  char magic[sizeof(snapshot::magic)];
+  std::uint32_t version{};
+  std::uint32_t n_agents{};
+  if (!m_in.read(magic, sizeof(magic)) ||
+      !std::equal(std::begin(magic),
+                  std::end(magic),
+                  std::begin(snapshot::magic)) ||
+      !read_value(m_in, version) || version != snapshot::version ||
+      !read_value(m_in, n_agents)) {
+    throw std::runtime_error("SnapshotReader: not a snapshot stream " +
+                             path.string());
+  }
+
+  m_agents.resize(n_agents);
+  for (auto& agent : m_agents) {
+    std::int32_t id{};
+    std::uint16_t type_len{};
+    if (!read_value(m_in, id) || !read_value(m_in, type_len)) {
+      throw std::runtime_error("SnapshotReader: truncated header");
+    }
+    agent.id = id;
+    agent.type.resize(type_len);
+    if (!m_in.read(agent.type.data(), type_len)) {
+      throw std::runtime_error("SnapshotReader: truncated header");
+    }
+  }
+}
+
+std::optional<snapshot::Tick>
+SnapshotReader::next()
+{
+  std::uint32_t payload_len{};
+  if (!read_value(m_in, payload_len)) {
+    return std::nullopt;
+  }
+  m_buffer.resize(payload_len);
+  if (!m_in.read(m_buffer.data(), payload_len)) {
+    // Truncated by a crash mid-write
+    return std::nullopt;
+  }
+
+  PayloadCursor cursor{ m_buffer };
+  snapshot::Tick tick{};
+  tick.tick = cursor.read<std::uint32_t>();
+  cursor.read_column(tick.capital, m_agents.size());
+  cursor.read_column(tick.shares, m_agents.size());
+  cursor.read_levels(tick.bids);
+  cursor.read_levels(tick.asks);
+  return tick;
+}
+}
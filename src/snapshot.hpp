@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "order.hpp"
+#include "order_book.hpp"
+#include "population.hpp"
+#include "price_ladder.hpp"
+
+// Binary snapshot stream, one record per tick, written as the run goes.
+// All integers are little-endian.
+//
+//   Header
+//     char[8]  magic "LEYVALSS"
+//     u32      version
+//     u32      n_agents
+//     n_agents x { i32 id, u16 type_len, char[type_len] type }
+//   Record, repeated
+//     u32      payload_len, of the rest of the record
+//     u32      tick, the Exchange's, which skips ticks with no agent due
+//     i64[n_agents] capital (Money underlying_value), in header order
+//     i32[n_agents] shares
+//     u32      n_bid_levels
+//     i64[n_bid_levels] price, best first
+//     i32[n_bid_levels] num_orders
+//     u32      n_ask_levels
+//     i64[n_ask_levels] price, best first
+//     i32[n_ask_levels] num_orders
+//
+// Records are flushed whole, so a crashed run leaves a readable prefix, and
+// at most one truncated record at the end, which readers skip.
+namespace leyval {
+namespace snapshot {
+constexpr char magic[8]{ 'L', 'E', 'Y', 'V', 'A', 'L', 'S', 'S' };
+constexpr std::uint32_t version{ 1 };
+
+struct AgentInfo
+{
+  int id{ 0 };
+  std::string type;
+};
+
+struct Level
+{
+  std::int64_t price{ 0 };
+  int num_orders{ 0 };
+};
+
+struct Tick
+{
+  std::uint32_t tick{ 0 };
+  std::vector<std::int64_t> capital;
+  std::vector<int> shares;
+  std::vector<Level> bids;
+  std::vector<Level> asks;
+};
+}
+
+// Keeps only the current tick in memory
+class SnapshotWriter
+{
+public:
+  explicit SnapshotWriter(const std::filesystem::path& path);
+
+  // Exch is an Exchange. The first call also writes the header, so the agents
+  // must not change afterwards.
+  template<typename Exch>
+  void write(const Exch& exch)
+  {
+    const auto& agents{ exch.get_agents() };
+    const int num_agents{ static_cast<int>(agents.size()) };
+    if (!m_header_written) {
+      std::vector<snapshot::AgentInfo> infos;
+      for (int id{ 0 }; id < num_agents; ++id) {
+        infos.push_back(
+          { id, std::string{ agent_type_name(agents.type(id)) } });
+      }
+      write_header(infos);
+    }
+
+    m_tick.tick = exch.get_tick();
+    m_tick.capital.clear();
+    m_tick.shares.clear();
+    for (int id{ 0 }; id < num_agents; ++id) {
+      m_tick.capital.push_back(agents.capital(id).underlying_value);
+      m_tick.shares.push_back(agents.shares(id));
+    }
+
+    const OrderBook& order_book{ exch.get_order_book() };
+    for (const OrderDir dir : { OrderDir::Bid, OrderDir::Ask }) {
+      auto& levels{ dir == OrderDir::Bid ? m_tick.bids : m_tick.asks };
+      levels.clear();
+      order_book.for_each_level(
+        dir, [&levels](Money price, const PriceLadder::Level& level) {
+          levels.push_back({ price.underlying_value, level.size() });
+        });
+    }
+
+    write_tick();
+  }
+
+private:
+  std::ofstream m_out;
+  bool m_header_written{ false };
+  std::size_t m_num_agents{ 0 };
+  snapshot::Tick m_tick;
+  // Reused for every record
+  std::vector<char> m_buffer;
+
+  void write_header(const std::vector<snapshot::AgentInfo>& agents);
+  void write_tick();
+};
+
+class SnapshotReader
+{
+public:
+  // Throws std::runtime_error if path is not a snapshot stream
+  explicit SnapshotReader(const std::filesystem::path& path);
+
+  [[nodiscard]] const std::vector<snapshot::AgentInfo>& agents() const
+  {
+    return m_agents;
+  }
+
+  // Empty once there are no more complete records
+  std::optional<snapshot::Tick> next();
+
+private:
+  std::ifstream m_in;
+  std::vector<snapshot::AgentInfo> m_agents;
+  std::vector<char> m_buffer;
+};
+}
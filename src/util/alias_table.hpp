@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+
+namespace leyval {
+// Walker's alias method, built with Vose's algorithm.
+// Draws index i with probability weights[i] / sum(weights), in O(1) from a
+// single PRNG call, as std::discrete_distribution does by binary search.
+// Sampling is const, so one table can be shared by every agent of a type,
+// even when they decide in parallel.
+template<std::size_t N>
+class AliasTable
+{
+public:
+  constexpr explicit AliasTable(const std::array<double, N>& weights)
+  {
+    double total{ 0 };
+    for (const double weight : weights) {
+      if (weight < 0) {
+        throw std::invalid_argument("AliasTable: negative weight");
+      }
+      total += weight;
+    }
+    if (!(total > 0)) {
+      throw std::invalid_argument("AliasTable: weights sum to 0");
+    }
+
+    // Scaled so that the mean is 1. Each column under 1 is topped up from one
+    // over 1, which is then put back by what is left of it.
+    std::array<double, N> scaled{};
+    std::array<std::size_t, N> small{};
+    std::array<std::size_t, N> large{};
+    std::size_t num_small{ 0 };
+    std::size_t num_large{ 0 };
+    for (std::size_t i{ 0 }; i < N; ++i) {
+      scaled[i] = weights[i] * N / total;
+      if (scaled[i] < 1) {
+        small[num_small++] = i;
+      } else {
+        large[num_large++] = i;
+      }
+    }
+
+    while (num_small > 0 && num_large > 0) {
+      const std::size_t s{ small[--num_small] };
+      const std::size_t l{ large[--num_large] };
+      m_prob[s] = scaled[s];
+      m_alias[s] = l;
+      scaled[l] += scaled[s] - 1;
+      if (scaled[l] < 1) {
+        small[num_small++] = l;
+      } else {
+        large[num_large++] = l;
+      }
+    }
+    // Left over only by rounding, so are (close to) exactly 1
+    while (num_large > 0) {
+      const std::size_t l{ large[--num_large] };
+      m_prob[l] = 1;
+      m_alias[l] = l;
+    }
+    while (num_small > 0) {
+      const std::size_t s{ small[--num_small] };
+      m_prob[s] = 1;
+      m_alias[s] = s;
+    }
+  }
+
+  template<class PRNG>
+  std::size_t operator()(PRNG& prng) const
+  {
+    // Column from the integer part, and whether to take its alias from the
+    // fractional part
+    const double u{ std::generate_canonical<double, 32>(prng) * N };
+    const std::size_t column{ std::min(static_cast<std::size_t>(u), N - 1) };
+    return u - column < m_prob[column] ? column : m_alias[column];
+  }
+
+  // Probability of drawing i, as recovered from the table
+  [[nodiscard]] constexpr double probability(std::size_t i) const
+  {
+    double mass{ m_prob[i] };
+    for (std::size_t column{ 0 }; column < N; ++column) {
+      if (m_alias[column] == i && column != i) {
+        mass += 1 - m_prob[column];
+      }
+    }
+    return mass / N;
+  }
+
+  [[nodiscard]] static constexpr std::size_t size() { return N; }
+
+private:
+  // Chance of keeping column i, rather than taking m_alias[i]
+  std::array<double, N> m_prob{};
+  std::array<std::size_t, N> m_alias{};
+};
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <ranges>
+#include <vector>
+
+namespace leyval {
+// Binary indexed tree over non-negative weights.
+// After an O(n) assign(), appends, point updates and weighted sampling of an
+// index are all O(log n), so a distribution can be drawn from repeatedly while
+// its weights change.
+template<typename T>
+class FenwickTree
+{
+public:
+  template<std::ranges::sized_range R>
+  void assign(const R& weights)
+  {
+    m_size = std::ranges::size(weights);
+    m_tree.assign(m_size + 1, T{ 0 });
+    m_total = T{ 0 };
+
+    std::size_t i{ 1 };
+    for (const auto w : weights) {
+      m_tree[i++] = w;
+      m_total += w;
+    }
+    for (i = 1; i <= m_size; ++i) {
+      const std::size_t parent{ i + (i & -i) };
+      if (parent <= m_size) {
+        m_tree[parent] += m_tree[i];
+      }
+    }
+  }
+
+  // Appends a weight in O(log n)
+  void push_back(T weight)
+  {
+    if (m_tree.empty()) {
+      m_tree.push_back(T{ 0 });
+    }
+    const std::size_t i{ m_size + 1 };
+    // Node i covers (i - lowbit(i), i]
+    m_tree.push_back(weight + prefix_sum(m_size) -
+                     prefix_sum(i - (i & -i)));
+    m_size = i;
+    m_total += weight;
+  }
+
+  // Empties the tree, keeping its storage
+  void clear()
+  {
+    m_tree.clear();
+    m_size = 0;
+    m_total = T{ 0 };
+  }
+
+  void add(std::size_t idx, T delta)
+  {
+    m_total += delta;
+    for (std::size_t i{ idx + 1 }; i <= m_size; i += i & -i) {
+      m_tree[i] += delta;
+    }
+  }
+
+  // Returns the index i where prefix_sum(i) <= u < prefix_sum(i + 1).
+  // With u uniform in [0, total()), i is drawn proportional to its weight.
+  [[nodiscard]] std::size_t find(T u) const
+  {
+    assert(T{ 0 } <= u && u < m_total && "u must be in [0, total())");
+    std::size_t pos{ 0 };
+    for (std::size_t step{ std::bit_floor(m_size) }; step > 0; step >>= 1) {
+      if (pos + step <= m_size && m_tree[pos + step] <= u) {
+        pos += step;
+        u -= m_tree[pos];
+      }
+    }
+    return pos;
+  }
+
+  // Sum of the first n weights
+  [[nodiscard]] T prefix_sum(std::size_t n) const
+  {
+    T sum{ 0 };
+    for (std::size_t i{ n }; i > 0; i -= i & -i) {
+      sum += m_tree[i];
+    }
+    return sum;
+  }
+
+  [[nodiscard]] T value(std::size_t idx) const
+  {
+    return prefix_sum(idx + 1) - prefix_sum(idx);
+  }
+
+  [[nodiscard]] T total() const { return m_total; }
+  [[nodiscard]] std::size_t size() const { return m_size; }
+
+private:
+  // 1-indexed, m_tree[0] is unused. Empty until the first weight, so an
+  // empty tree does not allocate.
+  std::vector<T> m_tree;
+  std::size_t m_size{ 0 };
+  T m_total{ 0 };
+};
+}
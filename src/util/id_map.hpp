@@ -0,0 +1,128 @@
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace leyval {
+// Open-addressed hash map from a 64-bit id to T, with linear probing.
+// Sized to the ids it holds rather than to their range, so a long-lived id
+// does not make it grow with every id inserted after it. Erasing shifts the
+// entries after it back rather than leaving tombstones, so probes stay short
+// however many ids come and go. Only grows, and only allocates when it does.
+template<typename T>
+class IdMap
+{
+public:
+  // Reserved to mark empty slots
+  static constexpr std::uint64_t empty_id{
+    std::numeric_limits<std::uint64_t>::max()
+  };
+
+  // Makes room for num_ids ids, so that insert does not allocate until there
+  // are more
+  void reserve(std::size_t num_ids)
+  {
+    if (2 * num_ids > m_slots.size()) {
+      rehash(std::bit_ceil(std::max(2 * num_ids, min_capacity)));
+    }
+  }
+
+  // id must not be in the map already
+  void insert(std::uint64_t id, T value)
+  {
+    assert(id != empty_id);
+    reserve(m_size + 1);
+    std::size_t i{ home(id) };
+    while (m_slots[i].first != empty_id) {
+      assert(m_slots[i].first != id && "id must be unique");
+      i = (i + 1) & m_mask;
+    }
+    m_slots[i] = { id, std::move(value) };
+    ++m_size;
+  }
+
+  // nullptr if id is not in the map
+  [[nodiscard]] T* find(std::uint64_t id)
+  {
+    const std::size_t i{ slot_of(id) };
+    return i == npos ? nullptr : &m_slots[i].second;
+  }
+
+  // Returns whether id was in the map
+  bool erase(std::uint64_t id)
+  {
+    std::size_t hole{ slot_of(id) };
+    if (hole == npos) {
+      return false;
+    }
+    // Backward shift: move up each later entry of the run whose home is not
+    // between the hole and it, so that every probe still reaches its entry
+    for (std::size_t i{ (hole + 1) & m_mask }; m_slots[i].first != empty_id;
+         i = (i + 1) & m_mask) {
+      const std::size_t dist_home{ (i - home(m_slots[i].first)) & m_mask };
+      const std::size_t dist_hole{ (i - hole) & m_mask };
+      if (dist_home >= dist_hole) {
+        m_slots[hole] = std::move(m_slots[i]);
+        hole = i;
+      }
+    }
+    m_slots[hole].first = empty_id;
+    --m_size;
+    return true;
+  }
+
+  [[nodiscard]] std::size_t size() const { return m_size; }
+  [[nodiscard]] std::size_t capacity() const { return m_slots.size(); }
+
+private:
+  static constexpr std::size_t min_capacity{ 16 };
+  static constexpr std::size_t npos{ std::numeric_limits<std::size_t>::max() };
+
+  // Each a power of two, at most half full
+  std::vector<std::pair<std::uint64_t, T>> m_slots;
+  std::size_t m_mask{ 0 };
+  std::size_t m_size{ 0 };
+
+  // Fibonacci hashing, which spreads out runs of consecutive ids
+  [[nodiscard]] std::size_t home(std::uint64_t id) const
+  {
+    return static_cast<std::size_t>(
+             (id * 11'400'714'819'323'198'485ULL) >>
+             (64 - std::countr_zero(m_slots.size()))) &
+           m_mask;
+  }
+
+  [[nodiscard]] std::size_t slot_of(std::uint64_t id) const
+  {
+    if (m_size == 0) {
+      return npos;
+    }
+    for (std::size_t i{ home(id) }; m_slots[i].first != empty_id;
+         i = (i + 1) & m_mask) {
+      if (m_slots[i].first == id) {
+        return i;
+      }
+    }
+    return npos;
+  }
+
+  void rehash(std::size_t capacity)
+  {
+    std::vector<std::pair<std::uint64_t, T>> old(
+      capacity, std::pair<std::uint64_t, T>{ empty_id, T{} });
+    old.swap(m_slots);
+    m_mask = capacity - 1;
+    m_size = 0;
+    for (auto& [id, value] : old) {
+      if (id != empty_id) {
+        insert(id, std::move(value));
+      }
+    }
+  }
+};
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace leyval {
+// Philox4x32-10 counter-based generator, from Salmon et al., "Parallel random
+// numbers: as easy as 1, 2, 3" (SC '11).
+// Output n of a stream is a pure function of (key, stream, n), so streams can
+// be split off, and moved to any position, in O(1), and the state is 48 bytes
+// rather than mt19937's 5000.
+// A UniformRandomBitGenerator, seedable like the std engines, so it can stand
+// in for std::mt19937 as a PRNG.
+class Philox4x32
+{
+public:
+  using result_type = std::uint32_t;
+  static constexpr std::uint64_t default_seed{ 20111115 };
+
+  Philox4x32()
+    : Philox4x32(default_seed)
+  {
+  }
+
+  explicit Philox4x32(std::uint64_t key, std::uint64_t stream = 0)
+    : m_key{ low(key), high(key) }
+    , m_counter{ 0, 0, low(stream), high(stream) }
+  {
+  }
+
+  // Takes the key and stream from seq, e.g. a std::seed_seq
+  template<class SeedSeq>
+    requires(!std::is_convertible_v<SeedSeq, std::uint64_t>)
+  explicit Philox4x32(SeedSeq& seq)
+  {
+    std::array<std::uint32_t, 4> words{};
+    seq.generate(words.begin(), words.end());
+    m_key = { words[0], words[1] };
+    m_counter = { 0, 0, words[2], words[3] };
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max()
+  {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  result_type operator()()
+  {
+    if (m_index == m_block.size()) {
+      m_block = generate(m_counter, m_key);
+      set_block(block() + 1);
+      m_index = 0;
+    }
+    return m_block[m_index++];
+  }
+
+  void discard(unsigned long long n)
+  {
+    // Whatever is left of the current block first
+    const std::uint64_t buffered{ m_block.size() - m_index };
+    if (n <= buffered) {
+      m_index += static_cast<unsigned>(n);
+      return;
+    }
+    n -= buffered;
+    set_block(block() + n / m_block.size());
+    m_index = static_cast<unsigned>(m_block.size());
+    for (unsigned long long i{ 0 }; i < n % m_block.size(); ++i) {
+      (*this)();
+    }
+  }
+
+  // Moves to the start of block n of this stream, i.e. output 4 * n
+  void seek(std::uint64_t n)
+  {
+    set_block(n);
+    m_index = static_cast<unsigned>(m_block.size());
+  }
+
+  // Stream id under the same key, from the start. Distinct ids give
+  // independent streams.
+  [[nodiscard]] Philox4x32 split(std::uint64_t stream) const
+  {
+    return Philox4x32{ key(), stream };
+  }
+
+  [[nodiscard]] std::uint64_t key() const { return join(m_key[0], m_key[1]); }
+  [[nodiscard]] std::uint64_t stream() const
+  {
+    return join(m_counter[2], m_counter[3]);
+  }
+
+  // The 4 outputs of counter under key
+  static constexpr std::array<std::uint32_t, 4> generate(
+    std::array<std::uint32_t, 4> counter,
+    std::array<std::uint32_t, 2> key)
+  {
+    for (int round{ 0 }; round < 10; ++round) {
+      const std::uint64_t product0{ std::uint64_t{ multiplier0 } * counter[0] };
+      const std::uint64_t product1{ std::uint64_t{ multiplier1 } * counter[2] };
+      counter = { high(product1) ^ counter[1] ^ key[0],
+                  low(product1),
+                  high(product0) ^ counter[3] ^ key[1],
+                  low(product0) };
+      key[0] += weyl0;
+      key[1] += weyl1;
+    }
+    return counter;
+  }
+
+  friend bool operator==(const Philox4x32&, const Philox4x32&) = default;
+
+private:
+  static constexpr std::uint32_t multiplier0{ 0xD2511F53 };
+  static constexpr std::uint32_t multiplier1{ 0xCD9E8D57 };
+  static constexpr std::uint32_t weyl0{ 0x9E3779B9 };
+  static constexpr std::uint32_t weyl1{ 0xBB67AE85 };
+
+  std::array<std::uint32_t, 2> m_key{};
+  // Block within the stream in the low half, stream id in the high half
+  std::array<std::uint32_t, 4> m_counter{};
+  std::array<std::uint32_t, 4> m_block{};
+  // Next output of m_block, which is used up when at its size
+  unsigned m_index{ 4 };
+
+  static constexpr std::uint32_t low(std::uint64_t x)
+  {
+    return static_cast<std::uint32_t>(x);
+  }
+  static constexpr std::uint32_t high(std::uint64_t x)
+  {
+    return static_cast<std::uint32_t>(x >> 32);
+  }
+  static constexpr std::uint64_t join(std::uint32_t lo, std::uint32_t hi)
+  {
+    return std::uint64_t{ hi } << 32 | lo;
+  }
+
+  [[nodiscard]] std::uint64_t block() const
+  {
+    return join(m_counter[0], m_counter[1]);
+  }
+  void set_block(std::uint64_t n)
+  {
+    m_counter[0] = low(n);
+    m_counter[1] = high(n);
+  }
+};
+}
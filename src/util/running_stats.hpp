@@ -0,0 +1,43 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace leyval {
+// Streaming mean, variance and range (Welford), in O(1) memory.
+// Values are not kept, so any number of them can be added.
+class RunningStats
+{
+public:
+  void add(double x)
+  {
+    ++m_count;
+    const double delta{ x - m_mean };
+    m_mean += delta / static_cast<double>(m_count);
+    m_m2 += delta * (x - m_mean);
+    m_min = std::min(m_min, x);
+    m_max = std::max(m_max, x);
+  }
+
+  [[nodiscard]] std::int64_t count() const { return m_count; }
+  [[nodiscard]] double mean() const { return m_mean; }
+  // Sample variance, 0 with fewer than 2 values
+  [[nodiscard]] double variance() const
+  {
+    return m_count < 2 ? 0.0 : m_m2 / static_cast<double>(m_count - 1);
+  }
+  [[nodiscard]] double stddev() const { return std::sqrt(variance()); }
+  [[nodiscard]] double min() const { return m_min; }
+  [[nodiscard]] double max() const { return m_max; }
+
+private:
+  std::int64_t m_count{ 0 };
+  double m_mean{ 0.0 };
+  // Sum of squared differences from the mean
+  double m_m2{ 0.0 };
+  double m_min{ std::numeric_limits<double>::infinity() };
+  double m_max{ -std::numeric_limits<double>::infinity() };
+};
+}
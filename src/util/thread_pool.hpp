@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace leyval {
+// Fixed set of worker threads for fork-join loops.
+// Tasks are handed out one index at a time from a shared counter, so a slow
+// task does not hold up the others queued behind it.
+class ThreadPool
+{
+public:
+  // The calling thread also runs tasks, so this starts num_threads - 1 workers
+  explicit ThreadPool(std::size_t num_threads)
+  {
+    for (std::size_t i{ 1 }; i < num_threads; ++i) {
+      m_workers.emplace_back([this] { work(); });
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool()
+  {
+    m_stop.store(true);
+    ++m_generation;
+    m_generation.notify_all();
+    // Join before the members the workers use are destroyed
+    m_workers.clear();
+  }
+
+  [[nodiscard]] std::size_t size() const { return m_workers.size() + 1; }
+
+  // Calls task(i) for every i in [0, n), in no particular order, and returns
+  // once all have finished. If a task throws, the tasks not yet started are
+  // skipped, and the first exception is rethrown here once every worker is
+  // done with task.
+  // Workers call task through a pointer, so this does not allocate.
+  template<typename F>
+  void parallel_for(std::size_t n, F task)
+  {
+    m_task = &task;
+    m_run_task = [](void* task, std::size_t i) { (*static_cast<F*>(task))(i); };
+    m_num_tasks = n;
+    m_next.store(0);
+    m_error = nullptr;
+    m_failed.store(false);
+    m_busy.store(m_workers.size());
+    // Publishes the above to the workers
+    ++m_generation;
+    m_generation.notify_all();
+
+    run_tasks();
+
+    for (std::size_t busy{ m_busy.load() }; busy != 0; busy = m_busy.load()) {
+      m_busy.wait(busy);
+    }
+    m_task = nullptr;
+    m_run_task = nullptr;
+    if (m_error) {
+      std::rethrow_exception(std::exchange(m_error, nullptr));
+    }
+  }
+
+private:
+  std::vector<std::jthread> m_workers;
+
+  // Only written while workers are idle
+  void* m_task{ nullptr };
+  void (*m_run_task)(void*, std::size_t){ nullptr };
+  std::size_t m_num_tasks{ 0 };
+
+  std::atomic<std::size_t> m_generation{ 0 };
+  std::atomic<std::size_t> m_next{ 0 };
+  std::atomic<std::size_t> m_busy{ 0 };
+  std::atomic<bool> m_stop{ false };
+  // Set by the first task to throw, which alone writes m_error
+  std::atomic<bool> m_failed{ false };
+  std::exception_ptr m_error;
+
+  void run_tasks()
+  {
+    for (std::size_t i{ m_next++ }; i < m_num_tasks; i = m_next++) {
+      try {
+        m_run_task(m_task, i);
+      } catch (...) {
+        if (!m_failed.exchange(true)) {
+          m_error = std::current_exception();
+        }
+        m_next.store(m_num_tasks);
+      }
+    }
+  }
+
+  void work()
+  {
+    std::size_t seen_generation{ 0 };
+    while (true) {
+      m_generation.wait(seen_generation);
+      seen_generation = m_generation.load();
+      if (m_stop.load()) {
+        return;
+      }
+
+      run_tasks();
+
+      --m_busy;
+      m_busy.notify_one();
+    }
+  }
+};
+}
@@ -1,49 +1,75 @@
 #pragma once
 
-#include <functional>
+#include <concepts>
 #include <stdexcept>
+#include <type_traits>
 
 namespace leyval {
+// Timer that always waits the same number of ticks
+struct FixedTicks
+{
+  unsigned int ticks;
+  unsigned int operator()() const { return ticks; }
+};
+
+// Counts down the ticks drawn from Gen, firing when they run out.
+// Gen is held by value and called directly, so drawing does not allocate or
+// go through a std::function.
+template<typename Gen>
+  requires std::invocable<Gen&> &&
+           std::convertible_to<std::invoke_result_t<Gen&>, unsigned int>
 class Timer
 {
 public:
   using num_t = unsigned int;
-  using gen_t = std::function<num_t()>;
 
   explicit Timer(num_t num)
-    : Timer{ [=]() { return num; } }
+    requires std::same_as<Gen, FixedTicks>
+    : Timer{ FixedTicks{ num } }
   {
   }
 
   // Please supply this with as little state as possible
   // Ideally is a pure function, or just RNG as state.
-  Timer(gen_t gen)
+  Timer(Gen gen)
     : m_gen{ gen }
-    , m_timer{ gen() }
+    , m_timer{ draw(m_gen) }
   {
-    zero_check();
   }
 
-  void reset()
-  {
-    m_timer = m_gen();
-    zero_check();
-  };
+  void reset() { m_timer = draw(m_gen); }
 
-  [[nodiscard]] bool tick_and_check()
+  [[nodiscard]] bool tick_and_check() { return advance(1); }
+
+  // Moves on ticks at once, so a scheduler can skip idle ticks rather than
+  // tick every timer. Returns whether the timer fired on the last of them.
+  // Going past firing would lose it, so that needs a reset() first.
+  [[nodiscard]] bool advance(num_t ticks)
   {
-    zero_check();
-    m_timer -= 1;
+    if (m_timer < ticks) [[unlikely]] {
+      throw std::logic_error("Timer: advanced past firing");
+    }
+    m_timer -= ticks;
     return m_timer == 0;
   }
 
+  // Ticks left until the timer fires, 0 once it has
+  [[nodiscard]] num_t ticks_until_fire() const { return m_timer; }
+
 private:
-  gen_t m_gen;
+  Gen m_gen;
   num_t m_timer;
-  void zero_check()
+
+  // Checked once per draw, rather than on every tick
+  static num_t draw(Gen& gen)
   {
-    if (m_timer == 0)
+    const num_t ticks{ gen() };
+    if (ticks == 0) {
       throw std::logic_error("gen produced 0");
+    }
+    return ticks;
   }
 };
+
+Timer(unsigned int) -> Timer<FixedTicks>;
 }
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace leyval {
+// Hierarchical timing wheel of ids, each due at a tick.
+// Level k has 256 slots of 256^k ticks, so 4 levels cover every
+// std::uint32_t tick. An id sits at the level of the highest byte in which
+// its tick differs from now(), and moves down a level as now() reaches its
+// slot, so scheduling, and waking, an id is O(1) however far ahead it is.
+// Slots are intrusive lists threaded through per-id arrays, so an id can be
+// scheduled at most once at a time, and nothing allocates after resize().
+class TimingWheel
+{
+public:
+  explicit TimingWheel(std::size_t num_ids = 0) { resize(num_ids); }
+
+  // Ids run over [0, num_ids)
+  void resize(std::size_t num_ids)
+  {
+    m_next.resize(num_ids, none);
+    m_ticks.resize(num_ids, 0);
+  }
+
+  // id must not be scheduled already, and tick must not be before now()
+  void schedule(int id, std::uint32_t tick)
+  {
+    if (tick < m_now) {
+      throw std::invalid_argument("TimingWheel::schedule: tick is past");
+    }
+    m_ticks[id] = tick;
+    insert(id);
+    ++m_size;
+  }
+
+  // Earliest tick with an id due. Empty if nothing is scheduled.
+  [[nodiscard]] std::optional<std::uint32_t> next_tick() const;
+
+  // Moves now() on to tick, which must not be past next_tick(), so that no
+  // id is skipped
+  void advance_to(std::uint32_t tick);
+
+  // Appends the ids due at now(), most recently scheduled first, and
+  // unschedules them
+  void pop_due(std::vector<int>& ids)
+  {
+    int& head{ m_heads[0][m_now & slot_mask] };
+    for (int id{ head }; id != none; id = m_next[id]) {
+      ids.push_back(id);
+      --m_size;
+    }
+    head = none;
+    mark_empty(0, m_now & slot_mask);
+  }
+
+  [[nodiscard]] std::uint32_t now() const { return m_now; }
+  [[nodiscard]] std::size_t size() const { return m_size; }
+
+private:
+  static constexpr int none{ -1 };
+  static constexpr int slot_bits{ 8 };
+  static constexpr std::size_t num_slots{ 1 << slot_bits };
+  static constexpr std::uint32_t slot_mask{ num_slots - 1 };
+  static constexpr std::size_t num_levels{ 32 / slot_bits };
+  static constexpr std::size_t words_per_level{ num_slots / 64 };
+
+  using Heads = std::array<int, num_slots>;
+  std::array<Heads, num_levels> m_heads{ filled_heads() };
+  // Bit per slot, set when its list is not empty
+  std::array<std::array<std::uint64_t, words_per_level>, num_levels>
+    m_occupied{};
+  // Earliest tick in each occupied slot, so that finding the next tick does
+  // not walk a slot's list
+  std::array<std::array<std::uint32_t, num_slots>, num_levels> m_min_ticks{};
+  // Next id in the same slot, and when each id is due
+  std::vector<int> m_next;
+  std::vector<std::uint32_t> m_ticks;
+  std::uint32_t m_now{ 0 };
+  std::size_t m_size{ 0 };
+
+  static constexpr std::array<Heads, num_levels> filled_heads()
+  {
+    std::array<Heads, num_levels> heads{};
+    for (Heads& level : heads) {
+      level.fill(none);
+    }
+    return heads;
+  }
+
+  [[nodiscard]] std::size_t level_of(std::uint32_t tick) const
+  {
+    const std::uint32_t diff{ tick ^ m_now };
+    return diff == 0 ? 0 : (std::bit_width(diff) - 1) / slot_bits;
+  }
+  static std::size_t slot_of(std::uint32_t tick, std::size_t level)
+  {
+    return (tick >> (slot_bits * level)) & slot_mask;
+  }
+
+  void insert(int id)
+  {
+    const std::size_t level{ level_of(m_ticks[id]) };
+    const std::size_t slot{ slot_of(m_ticks[id], level) };
+    std::uint32_t& min_tick{ m_min_ticks[level][slot] };
+    min_tick = m_heads[level][slot] == none ? m_ticks[id]
+                                            : std::min(min_tick, m_ticks[id]);
+    m_next[id] = m_heads[level][slot];
+    m_heads[level][slot] = id;
+    m_occupied[level][slot / 64] |= std::uint64_t{ 1 } << (slot % 64);
+  }
+  void mark_empty(std::size_t level, std::size_t slot)
+  {
+    m_occupied[level][slot / 64] &= ~(std::uint64_t{ 1 } << (slot % 64));
+  }
+
+  // First occupied slot of level from slot first on, or num_slots if none
+  [[nodiscard]] std::size_t next_occupied(std::size_t level,
+                                          std::size_t first) const
+  {
+    for (std::size_t word{ first / 64 }; word < words_per_level; ++word) {
+      std::uint64_t bits{ m_occupied[level][word] };
+      if (word == first / 64) {
+        bits &= ~std::uint64_t{ 0 } << (first % 64);
+      }
+      if (bits != 0) {
+        return word * 64 + std::countr_zero(bits);
+      }
+    }
+    return num_slots;
+  }
+};
+
+inline std::optional<std::uint32_t>
+TimingWheel::next_tick() const
+{
+  if (m_size == 0) {
+    return std::nullopt;
+  }
+  // Ids at a level are due after every id at the levels below it, and slots
+  // within a level are in tick order. Only level 0 slots hold a single tick.
+  const std::size_t slot{ next_occupied(0, slot_of(m_now, 0)) };
+  if (slot != num_slots) {
+    return (m_now & ~slot_mask) | static_cast<std::uint32_t>(slot);
+  }
+  for (std::size_t level{ 1 }; level < num_levels; ++level) {
+    const std::size_t slot{ next_occupied(level, slot_of(m_now, level) + 1) };
+    if (slot != num_slots) {
+      return m_min_ticks[level][slot];
+    }
+  }
+  return std::nullopt;
+}
+
+inline void
+TimingWheel::advance_to(std::uint32_t tick)
+{
+  const std::optional<std::uint32_t> next{ next_tick() };
+  if (tick < m_now || (next && *next < tick)) {
+    throw std::invalid_argument("TimingWheel::advance_to: skips due ids");
+  }
+  m_now = tick;
+  // Slots that now() has reached move down. From the top, so ids that land in
+  // a lower level's reached slot move again.
+  for (std::size_t level{ num_levels - 1 }; level > 0; --level) {
+    const std::size_t slot{ slot_of(m_now, level) };
+    int id{ m_heads[level][slot] };
+    m_heads[level][slot] = none;
+    mark_empty(level, slot);
+    while (id != none) {
+      const int next_id{ m_next[id] };
+      insert(id);
+      id = next_id;
+    }
+  }
+}
+}
@@ -1,8 +1,152 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <numbers>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
 namespace leyval {
 
+// Inverse of the standard normal CDF.
+// Acklam's rational approximation, then one Halley step, which brings it to
+// double precision. Stays accurate deep in the lower tail, so upper tail
+// quantiles are best taken as -inverse_normal_cdf(1 - p).
+inline double
+inverse_normal_cdf(double p)
+{
+  constexpr double a[]{ -3.969683028665376e+01, 2.209460984245205e+02,
+                        -2.759285104469687e+02, 1.383577518672690e+02,
+                        -3.066479806614716e+01, 2.506628277459239e+00 };
+  constexpr double b[]{ -5.447609879822406e+01, 1.615858368580409e+02,
+                        -1.556989798598866e+02, 6.680131188771972e+01,
+                        -1.328068155288572e+01 };
+  constexpr double c[]{ -7.784894002430293e-03, -3.223964580411365e-01,
+                        -2.400758277161838e+00, -2.549732539343734e+00,
+                        4.374664141464968e+00,  2.938163982698783e+00 };
+  constexpr double d[]{ 7.784695709041462e-03, 3.224671290700398e-01,
+                        2.445134137142996e+00, 3.754408661907416e+00 };
+  constexpr double p_low{ 0.02425 };
+
+  if (p <= 0) {
+    return -std::numeric_limits<double>::infinity();
+  }
+  if (p >= 1) {
+    return std::numeric_limits<double>::infinity();
+  }
+
+  double x{};
+  if (p < p_low || 1 - p_low < p) {
+    const double q{ std::sqrt(-2 * std::log(p < p_low ? p : 1 - p)) };
+    x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+        ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+    x = p < p_low ? x : -x;
+  } else {
+    const double q{ p - 0.5 };
+    const double r{ q * q };
+    x = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) *
+        q /
+        (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+  }
+
+  const double e{ 0.5 * std::erfc(-x / std::numbers::sqrt2) - p };
+  const double u{ e * std::sqrt(2 * std::numbers::pi) * std::exp(x * x / 2) };
+  return x - u / (1 + x * u / 2);
+}
+
+// Maps a uniform in [0, 1] to Distribution restricted to [lower, upper], by
+// inverting its CDF over that window, so every sample costs the same however
+// little mass the window has.
+// Specialized for the distributions with a closed form.
+template<class Distribution>
+struct TruncatedInverseCdf;
+
+template<std::floating_point T>
+struct TruncatedInverseCdf<std::exponential_distribution<T>>
+{
+  TruncatedInverseCdf(const std::exponential_distribution<T>& dist,
+                      T lower,
+                      T upper)
+    : m_lower{ std::max(lower, T{ 0 }) }
+    , m_upper{ upper }
+    , m_lambda{ dist.lambda() }
+    // Mass of the window, relative to the tail from m_lower.
+    // Memorylessness keeps it well away from 0 however far out m_lower is.
+    , m_window_mass{ -std::expm1(-m_lambda * (m_upper - m_lower)) }
+  {
+  }
+
+  T operator()(double u) const
+  {
+    const double x{ m_lower - std::log1p(-u * m_window_mass) / m_lambda };
+    return std::min(static_cast<T>(x), m_upper);
+  }
+
+private:
+  double m_lower;
+  T m_upper;
+  double m_lambda;
+  double m_window_mass;
+};
+
+template<std::floating_point T>
+struct TruncatedInverseCdf<std::normal_distribution<T>>
+{
+  TruncatedInverseCdf(const std::normal_distribution<T>& dist,
+                      T lower,
+                      T upper)
+    : m_mean{ dist.mean() }
+    , m_stddev{ dist.stddev() }
+    , m_lower{ lower }
+    , m_upper{ upper }
+  {
+    const double alpha{ (lower - m_mean) / m_stddev };
+    const double beta{ (upper - m_mean) / m_stddev };
+    // A window above the mean is worked in survival probabilities, which stay
+    // precise in the tail where the CDF rounds to 1. Mirrored, it is the same
+    // as a window below the mean.
+    m_sign = alpha > 0 ? -1 : 1;
+    m_p_lower = cdf(m_sign * alpha);
+    m_p_width = cdf(m_sign * beta) - m_p_lower;
+  }
+
+  T operator()(double u) const
+  {
+    const double z{ m_sign * inverse_normal_cdf(m_p_lower + u * m_p_width) };
+    const T x{ static_cast<T>(m_mean + m_stddev * z) };
+    return std::clamp(x, m_lower, m_upper);
+  }
+
+private:
+  double m_mean;
+  double m_stddev;
+  T m_lower;
+  T m_upper;
+  double m_sign{ 1 };
+  double m_p_lower{ 0 };
+  double m_p_width{ 1 };
+
+  static double cdf(double z)
+  {
+    return 0.5 * std::erfc(-z / std::numbers::sqrt2);
+  }
+};
+
+template<class Distribution>
+concept HasTruncatedInverseCdf =
+  requires(const Distribution& dist, typename Distribution::result_type x) {
+    TruncatedInverseCdf<Distribution>{ dist, x, x }(0.5);
+  };
+
 // emulate named requirement RandomNumberDistribution
+// Samples Distribution restricted to [lower, upper]. Uses TruncatedInverseCdf
+// where it exists, which takes one uniform per sample. Otherwise falls back to
+// rejection, which takes 1 / (mass of the window) draws per sample on average.
 template<class Distribution, class PRNG>
 class TruncatedDistribution
 {
@@ -20,10 +164,59 @@ public:
   // 2: https://github.com/JuliaStats/Distributions.jl/pull/1553
   // 3:
   //   https://github.com/JuliaStats/Distributions.jl/blob/1e6801da6678164b13330cc1f16e670768d27330/src/truncate.jl#L216
-  // This implementation:
-  //   Simple rejection sampleing.
-  //   Does not give a special case for small mass.
   result_type operator()(PRNG& prng, result_type lower, result_type upper)
+  {
+    check_window(lower, upper);
+    if constexpr (HasTruncatedInverseCdf<Distribution>) {
+      const TruncatedInverseCdf<Distribution> inverse{ m_dist, lower, upper };
+      return inverse(std::generate_canonical<double, 32>(prng));
+    } else {
+      return reject(prng, lower, upper);
+    }
+  }
+
+  // Fills samples, drawing from prng in the same order as calling the scalar
+  // operator() once per sample.
+  // The window is set up once, then uniforms are drawn in one loop and
+  // transformed in another, which has no branches on the PRNG and so
+  // vectorizes.
+  void operator()(PRNG& prng,
+                  std::span<result_type> samples,
+                  result_type lower,
+                  result_type upper)
+  {
+    check_window(lower, upper);
+    if constexpr (HasTruncatedInverseCdf<Distribution>) {
+      const TruncatedInverseCdf<Distribution> inverse{ m_dist, lower, upper };
+      m_uniforms.resize(samples.size());
+      for (double& u : m_uniforms) {
+        u = std::generate_canonical<double, 32>(prng);
+      }
+      for (std::size_t i{ 0 }; i < samples.size(); ++i) {
+        samples[i] = inverse(m_uniforms[i]);
+      }
+    } else {
+      for (result_type& sample : samples) {
+        sample = reject(prng, lower, upper);
+      }
+    }
+  }
+
+private:
+  Distribution m_dist;
+  // Uniforms of the batch operator(), kept in double as in the scalar one,
+  // whatever result_type is. Reused, so batches do not allocate once grown.
+  std::vector<double> m_uniforms;
+
+  static void check_window(result_type lower, result_type upper)
+  {
+    if (!(lower <= upper)) {
+      throw std::invalid_argument("TruncatedDistribution: lower > upper");
+    }
+  }
+
+  // Simple rejection sampling. Does not give a special case for small mass.
+  result_type reject(PRNG& prng, result_type lower, result_type upper)
   {
     typename Distribution::result_type result{ m_dist(prng) };
     while (!((lower <= result) && (result <= upper))) {
@@ -31,8 +224,5 @@ public:
     }
     return result;
   }
-
-private:
-  Distribution m_dist;
 };
 }
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+#include <unistd.h>
+
+// File under temp_directory_path(), named for the test and this process so
+// that concurrent test runs do not share it. Removed when it goes out of
+// scope, also when a REQUIRE fails.
+class TempFile
+{
+public:
+  explicit TempFile(const std::string& name)
+    : m_path{ std::filesystem::temp_directory_path() /
+              ("leyval_" + std::to_string(::getpid()) + "_" + name) }
+  {
+  }
+
+  TempFile(const TempFile&) = delete;
+  TempFile& operator=(const TempFile&) = delete;
+
+  ~TempFile()
+  {
+    std::error_code ignored;
+    std::filesystem::remove(m_path, ignored);
+  }
+
+  [[nodiscard]] const std::filesystem::path& path() const { return m_path; }
+
+private:
+  std::filesystem::path m_path;
+};
@@ -0,0 +1,63 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <random>
+
+#include "../src/util/alias_table.hpp"
+
+SCENARIO("AliasTable draws indices in proportion to their weights",
+         "[alias_table]")
+{
+  using namespace leyval;
+
+  GIVEN("uneven integer weights")
+  {
+    constexpr std::array<double, 7> weights{ 1, 3, 5, 4, 3, 2, 2 };
+    constexpr double total{ 20 };
+    constexpr AliasTable table{ weights };
+
+    THEN("the table holds exactly the same distribution")
+    {
+      for (std::size_t i{ 0 }; i < weights.size(); ++i) {
+        REQUIRE(std::abs(table.probability(i) - weights[i] / total) < 1e-12);
+      }
+    }
+
+    WHEN("it is sampled many times")
+    {
+      std::mt19937 rng{ 4 };
+      const int num_draws{ 200'000 };
+      std::array<int, 7> counts{};
+      for (int n{ 0 }; n < num_draws; ++n) {
+        ++counts[table(rng)];
+      }
+
+      THEN("frequencies are within a few standard errors of the weights")
+      {
+        for (std::size_t i{ 0 }; i < weights.size(); ++i) {
+          const double p{ weights[i] / total };
+          const double std_err{ std::sqrt(p * (1 - p) / num_draws) };
+          const double freq{ static_cast<double>(counts[i]) / num_draws };
+          REQUIRE(std::abs(freq - p) < 5 * std_err);
+        }
+      }
+    }
+  }
+
+  GIVEN("a zero weight")
+  {
+    const AliasTable table{ std::array<double, 3>{ 1, 0, 1 } };
+    std::mt19937 rng{ 5 };
+
+    THEN("its index is never drawn")
+    {
+      int num_drawn{ 0 };
+      for (int n{ 0 }; n < 10'000; ++n) {
+        num_drawn += table(rng) == 1 ? 1 : 0;
+      }
+      REQUIRE(num_drawn == 0);
+    }
+  }
+}
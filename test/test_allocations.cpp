@@ -0,0 +1,80 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <utility>
+
+#include "../src/agent.hpp"
+#include "../src/exchange.hpp"
+
+// Counts every allocation made through the global operator new, in this whole
+// test binary. Only the difference across a section of code is meaningful.
+namespace {
+std::atomic<std::size_t> num_allocations{ 0 };
+}
+
+void*
+operator new(std::size_t size)
+{
+  ++num_allocations;
+  if (void* p{ std::malloc(size == 0 ? 1 : size) }) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void
+operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+SCENARIO("A tick in the steady state does not allocate", "[allocations]")
+{
+  using namespace leyval;
+  using PRNG = std::mt19937;
+
+  for (const std::size_t num_threads : { 1, 4 }) {
+    GIVEN("an Exchange of the JF population on " +
+          std::to_string(num_threads) + " threads")
+    {
+      PRNG rng{ 8 };
+      // Resting orders pile up over a JF run, so only the book's own storage
+      // grows past the warm up. Reserving it leaves the request path alone.
+      OrderBook order_book{};
+      order_book.reserve(10'000);
+      Exchange exch{ std::move(order_book),
+                     make_jf_agents(rng),
+                     MatchingSystem{ FifoMatching{} },
+                     rng };
+      exch.set_num_threads(num_threads);
+      exch.saturate();
+
+      WHEN("its buffers have grown to their working size")
+      {
+        for (int tick{ 0 }; tick < 200; ++tick) {
+          exch.run();
+        }
+
+        THEN("further ticks make no allocations")
+        {
+          const std::size_t before{ num_allocations.load() };
+          for (int tick{ 0 }; tick < 50; ++tick) {
+            exch.run();
+          }
+          REQUIRE(num_allocations.load() - before == 0);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,138 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "../src/event_log.hpp"
+#include "../src/exchange.hpp"
+#include "temp_file.hpp"
+
+SCENARIO("The event log is read back in place, in order", "[event_log]")
+{
+  using namespace leyval;
+  using event_log::Event;
+  using event_log::EventType;
+  const TempFile file{ "test_event_log.bin" };
+  const auto& path{ file.path() };
+
+  GIVEN("more events than fit in one block")
+  {
+    std::vector<Event> events{};
+    for (int i{ 0 }; i < 7; ++i) {
+      events.push_back({ .timestamp = i,
+                         .type = static_cast<EventType>(i % 4),
+                         .agent_id = i,
+                         .price = 100'00 + i,
+                         .volume = 2 * i,
+                         .direction = i % 2 == 0 ? OrderDir::Bid : OrderDir::Ask,
+                         .order_id = i % 3 == 0 ? event_log::no_order_id
+                                                : OrderId(i) });
+    }
+
+    {
+      EventLogWriter writer{ path, 3 };
+      for (const Event& event : events) {
+        writer.append(event);
+      }
+    }
+
+    WHEN("it is read back")
+    {
+      const EventLogReader reader{ path };
+
+      THEN("every event is there, in order, split into blocks")
+      {
+        REQUIRE(reader.size() == events.size());
+        REQUIRE(reader.blocks().size() == 3);
+        REQUIRE(reader.blocks().back().size() == 1);
+        REQUIRE(std::ranges::equal(reader, events));
+      }
+    }
+
+    WHEN("the last block was cut short, as by a crash")
+    {
+      std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+      const EventLogReader reader{ path };
+
+      THEN("the complete blocks are still read")
+      {
+        REQUIRE(reader.size() == 6);
+        REQUIRE(std::ranges::equal(
+          reader, std::vector<Event>(events.begin(), events.begin() + 6)));
+      }
+    }
+  }
+
+  GIVEN("an Exchange journaling to the log")
+  {
+    using PRNG = std::mt19937;
+    PRNG rng{ 2 };
+    Population<PRNG> agents{};
+    for (int i{ 0 }; i < 10; ++i) {
+      agents.add(AgentType::jf_provider, 1'000, rng);
+      agents.add(AgentType::jf_taker, 1'000, rng);
+    }
+    Exchange exch{
+      OrderBook{}, std::move(agents), MatchingSystem{ FifoMatching{} }, rng
+    };
+
+    {
+      EventLogWriter writer{ path };
+      exch.set_event_log(&writer);
+      exch.saturate();
+      for (int i{ 0 }; i < 10; ++i) {
+        exch.run();
+      }
+      exch.set_event_log(nullptr);
+    }
+
+    WHEN("it is read back")
+    {
+      const EventLogReader reader{ path };
+
+      THEN("the fills add up to what was traded")
+      {
+        int num_fills{ 0 };
+        std::int64_t fill_volume{ 0 };
+        for (const event_log::Block& block : reader.blocks()) {
+          for (std::size_t i{ 0 }; i < block.size(); ++i) {
+            if (static_cast<EventType>(block.type[i]) == EventType::fill) {
+              ++num_fills;
+              fill_volume += block.volume[i];
+            }
+          }
+        }
+        REQUIRE(num_fills == exch.get_stats().num_transactions);
+        REQUIRE(fill_volume == exch.get_stats().traded_volume);
+      }
+
+      THEN("each fill names a limit order of its agent on its side")
+      {
+        std::map<OrderId, std::pair<int, OrderDir>> limit_orders;
+        int num_fills{ 0 };
+        for (const Event& event : reader) {
+          if (event.type == EventType::limit_order) {
+            limit_orders[event.order_id] = { event.agent_id, event.direction };
+          } else if (event.type == EventType::fill) {
+            ++num_fills;
+            const auto found{ limit_orders.find(event.order_id) };
+            REQUIRE(found != limit_orders.end());
+            REQUIRE(found->second ==
+                    std::pair{ event.agent_id, event.direction });
+          }
+        }
+        REQUIRE(num_fills > 0);
+      }
+
+      THEN("the saturating orders come first, with sequential OrderIds")
+      {
+        const Event first{ *reader.begin() };
+        REQUIRE(first.type == EventType::limit_order);
+        REQUIRE(first.order_id == 0);
+      }
+    }
+  }
+}
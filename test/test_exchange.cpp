@@ -0,0 +1,172 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+#include "../src/event_log.hpp"
+#include "../src/exchange.hpp"
+#include "temp_file.hpp"
+
+SCENARIO("Exchange decides agents' orders the same on any number of threads",
+         "[exchange]")
+{
+  using namespace leyval;
+  using PRNG = std::mt19937;
+
+  auto run_exchange = [](std::size_t num_threads) {
+    PRNG rng{ 42 };
+    Population<PRNG> agents{};
+    for (int i{ 0 }; i < 30; ++i) {
+      agents.add(AgentType::jf_provider, 1'000, rng);
+    }
+    for (int i{ 0 }; i < 40; ++i) {
+      agents.add(AgentType::jf_taker, 1'000, rng);
+    }
+
+    Exchange exch{ OrderBook{},
+                   std::move(agents),
+                   MatchingSystem{ FifoMatching{} },
+                   rng };
+    exch.set_num_threads(num_threads);
+    exch.saturate();
+    for (int tick{ 0 }; tick < 20; ++tick) {
+      exch.run();
+    }
+    return nlohmann::json(exch);
+  };
+
+  GIVEN("the same seed")
+  {
+    const auto serial{ run_exchange(1) };
+
+    THEN("a parallel decision phase ends in the same state as a serial one")
+    {
+      for (const std::size_t num_threads : { 3, 8 }) {
+        const auto parallel{ run_exchange(num_threads) };
+        REQUIRE(parallel == serial);
+      }
+    }
+  }
+}
+
+SCENARIO("Exchange stamps orders with logical time", "[exchange]")
+{
+  using namespace leyval;
+  using PRNG = std::mt19937;
+
+  auto record_run = [](const std::filesystem::path& path) {
+    PRNG rng{ 5 };
+    Population<PRNG> agents{};
+    for (int i{ 0 }; i < 10; ++i) {
+      agents.add(AgentType::jf_provider, 1'000, rng);
+      agents.add(AgentType::jf_taker, 1'000, rng);
+    }
+    Exchange exch{
+      OrderBook{}, std::move(agents), MatchingSystem{ FifoMatching{} }, rng
+    };
+    EventLogWriter writer{ path };
+    exch.set_event_log(&writer);
+    exch.saturate();
+    for (int tick{ 0 }; tick < 5; ++tick) {
+      exch.run();
+    }
+    REQUIRE(exch.get_tick() == 5);
+  };
+
+  GIVEN("two runs from the same seed")
+  {
+    const TempFile file_a{ "test_clock_a.bin" };
+    const TempFile file_b{ "test_clock_b.bin" };
+    record_run(file_a.path());
+    record_run(file_b.path());
+    const EventLogReader log_a{ file_a.path() };
+    const EventLogReader log_b{ file_b.path() };
+
+    THEN("they journal the same orders at the same times")
+    {
+      REQUIRE(std::ranges::equal(log_a, log_b));
+    }
+
+    THEN("time only moves forward")
+    {
+      std::int64_t last{ 0 };
+      for (const event_log::Event& event : log_a) {
+        REQUIRE(last <= event.timestamp);
+        last = event.timestamp;
+      }
+      REQUIRE((last >> 32) == 5);
+    }
+
+    THEN("each tick's requests are applied in agent order, across types")
+    {
+      std::int64_t tick{ -1 };
+      int last_agent{ -1 };
+      for (const event_log::Event& event : log_a) {
+        // Tick 0 is saturate(), which is not agents deciding
+        if (event.type == event_log::EventType::fill ||
+            (event.timestamp >> 32) == 0) {
+          continue;
+        }
+        if ((event.timestamp >> 32) != tick) {
+          tick = event.timestamp >> 32;
+          last_agent = -1;
+        }
+        REQUIRE(last_agent <= event.agent_id);
+        last_agent = event.agent_id;
+      }
+    }
+  }
+}
+
+SCENARIO("Exchange skips ticks where no agent decides", "[exchange]")
+{
+  using namespace leyval;
+  using PRNG = std::mt19937;
+
+  GIVEN("agents that decide every 50 ticks on average")
+  {
+    PRNG rng{ 5 };
+    Population<PRNG> agents{};
+    for (int i{ 0 }; i < 5; ++i) {
+      agents.add(AgentType::jf_provider, 1'000, rng, 50);
+      agents.add(AgentType::jf_taker, 1'000, rng, 50);
+    }
+    Exchange exch{ OrderBook{},
+                   std::move(agents),
+                   MatchingSystem{ FifoMatching{} },
+                   rng };
+    exch.saturate();
+
+    THEN("each run() moves to the next tick with an agent due")
+    {
+      std::uint32_t last_tick{ exch.get_tick() };
+      for (int run{ 0 }; run < 30; ++run) {
+        exch.run();
+        REQUIRE(exch.get_tick() > last_tick);
+        last_tick = exch.get_tick();
+      }
+      // 10 agents wake about every 5 ticks between them
+      REQUIRE(last_tick > 60);
+    }
+  }
+
+  GIVEN("no agents, on several threads")
+  {
+    PRNG rng{ 5 };
+    Exchange exch{
+      OrderBook{}, Population<PRNG>{}, MatchingSystem{ FifoMatching{} }, rng
+    };
+    exch.set_num_threads(4);
+
+    THEN("each run() moves on one tick, with nothing to do")
+    {
+      exch.run();
+      exch.run();
+      REQUIRE(exch.get_tick() == 2);
+      REQUIRE(exch.get_stats().num_order_requests == 0);
+    }
+  }
+}
@@ -0,0 +1,82 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <vector>
+
+#include "../src/util/fenwick_tree.hpp"
+
+SCENARIO("FenwickTree", "[fenwick_tree]")
+{
+  using namespace leyval;
+  FenwickTree<long> tree{};
+
+  GIVEN("weights with a zero in between")
+  {
+    tree.assign(std::vector<long>{ 2, 0, 3, 1 });
+
+    THEN("the total is the sum of weights")
+    {
+      REQUIRE(tree.total() == 6);
+    }
+
+    THEN("find() maps each unit of weight to its index")
+    {
+      REQUIRE(tree.find(0) == 0);
+      REQUIRE(tree.find(1) == 0);
+      REQUIRE(tree.find(2) == 2);
+      REQUIRE(tree.find(4) == 2);
+      REQUIRE(tree.find(5) == 3);
+    }
+
+    WHEN("a weight is updated with add()")
+    {
+      tree.add(2, -3);
+      tree.add(1, 1);
+
+      THEN("find() and total() reflect it")
+      {
+        REQUIRE(tree.total() == 4);
+        REQUIRE(tree.find(2) == 1);
+        REQUIRE(tree.find(3) == 3);
+      }
+    }
+  }
+}
+
+SCENARIO("FenwickTree grows one weight at a time", "[fenwick_tree]")
+{
+  using namespace leyval;
+  const std::vector<long> weights{ 4, 0, 1, 7, 2, 0, 0, 3, 5, 1, 6 };
+  FenwickTree<long> appended{};
+  for (const long w : weights) {
+    appended.push_back(w);
+  }
+  FenwickTree<long> assigned{};
+  assigned.assign(weights);
+
+  THEN("it is the same tree as assigning every weight at once")
+  {
+    REQUIRE(appended.size() == weights.size());
+    REQUIRE(appended.total() == assigned.total());
+    for (std::size_t i{ 0 }; i < weights.size(); ++i) {
+      REQUIRE(appended.value(i) == weights[i]);
+      REQUIRE(appended.prefix_sum(i) == assigned.prefix_sum(i));
+    }
+    for (long u{ 0 }; u < assigned.total(); ++u) {
+      REQUIRE(appended.find(u) == assigned.find(u));
+    }
+  }
+
+  WHEN("it is cleared")
+  {
+    appended.clear();
+    appended.push_back(2);
+
+    THEN("it starts over")
+    {
+      REQUIRE(appended.size() == 1);
+      REQUIRE(appended.total() == 2);
+      REQUIRE(appended.find(1) == 0);
+    }
+  }
+}
@@ -1,5 +1,10 @@
 #include <catch2/catch_test_macros.hpp>
 
+#include <cstdint>
+#include <limits>
+#include <ranges>
+#include <stdexcept>
+
 #include "../src/fixed_point.hpp"
 
 SCENARIO("Fixed point supports numberical operations", "[fixed_point]")
@@ -119,3 +124,54 @@ SCENARIO("Fixed point utilities", "[fixed_point]")
     }
   }
 }
+
+SCENARIO("Fixed point is 64-bit and constexpr", "[fixed_point]")
+{
+  using namespace leyval;
+
+  // Rescaling is integer math, so it can happen at compile time
+  static_assert(Fixed<-2>{ 150 }.rescale<-4>() == Fixed<-4>{ 15'000 });
+  static_assert(Fixed<-4>{ -15'099 }.rescale<-2>() == Fixed<-2>{ -150 });
+  static_assert(Fixed<-2>{ 150 } * 3 == Fixed<-2>{ 450 });
+
+  WHEN("values pass 32 bits")
+  {
+    Fixed<-2> total{ 0 };
+    for (int fill{ 0 }; fill < 1'000; ++fill) {
+      total += Fixed<-2>{ 10'000'000 } * 1'000;
+    }
+
+    THEN("nothing is truncated to int")
+    {
+      REQUIRE(total == Fixed<-2>{ 10'000'000'000'000 });
+      REQUIRE(total.rescale<-6>() == Fixed<-6>{ 100'000'000'000'000'000 });
+    }
+  }
+
+  GIVEN("a result past 64 bits")
+  {
+    constexpr std::int64_t max{ std::numeric_limits<std::int64_t>::max() };
+    constexpr std::int64_t min{ std::numeric_limits<std::int64_t>::min() };
+
+    THEN("checked arithmetic throws")
+    {
+      using Checked = Fixed<-2, Overflow::checked>;
+      REQUIRE_THROWS_AS(Checked{ max } + Checked{ 1 }, std::overflow_error);
+      REQUIRE_THROWS_AS(Checked{ min } - Checked{ 1 }, std::overflow_error);
+      REQUIRE_THROWS_AS(Checked{ max / 2 } * 3, std::overflow_error);
+      REQUIRE_THROWS_AS(Checked{ max / 10 }.rescale<-4>(),
+                        std::overflow_error);
+      REQUIRE(Checked{ max - 1 } + Checked{ 1 } == Checked{ max });
+    }
+
+    THEN("saturating arithmetic clamps")
+    {
+      using Saturating = Fixed<-2, Overflow::saturating>;
+      REQUIRE(Saturating{ max } + Saturating{ 1 } == Saturating{ max });
+      REQUIRE(Saturating{ min } - Saturating{ 1 } == Saturating{ min });
+      REQUIRE(Saturating{ max / 2 } * -3 == Saturating{ min });
+      REQUIRE(Saturating{ min } / Saturating{ -1 } == Saturating{ max });
+      REQUIRE(Saturating{ 5 } - Saturating{ 7 } == Saturating{ -2 });
+    }
+  }
+}
@@ -0,0 +1,66 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <map>
+#include <random>
+
+#include "../src/util/id_map.hpp"
+
+SCENARIO("IdMap finds ids as they come and go", "[id_map]")
+{
+  using namespace leyval;
+  IdMap<int> map{};
+
+  GIVEN("ids inserted and erased at random")
+  {
+    std::mt19937 rng{ 3 };
+    std::uniform_int_distribution<std::uint64_t> draw_id(0, 500);
+    std::map<std::uint64_t, int> expected;
+    for (int i{ 0 }; i < 20'000; ++i) {
+      const std::uint64_t id{ draw_id(rng) };
+      if (expected.contains(id)) {
+        REQUIRE(map.erase(id));
+        expected.erase(id);
+      } else {
+        map.insert(id, i);
+        expected[id] = i;
+      }
+    }
+
+    THEN("it holds exactly the ids still in")
+    {
+      REQUIRE(map.size() == expected.size());
+      for (std::uint64_t id{ 0 }; id <= 500; ++id) {
+        const int* const found{ map.find(id) };
+        const auto it{ expected.find(id) };
+        if (it == expected.end()) {
+          REQUIRE(found == nullptr);
+          REQUIRE_FALSE(map.erase(id));
+        } else {
+          REQUIRE(found != nullptr);
+          REQUIRE(*found == it->second);
+        }
+      }
+    }
+  }
+
+  GIVEN("one id that stays while many later ones come and go")
+  {
+    map.insert(0, -1);
+    for (std::uint64_t id{ 1 }; id < 100'000; ++id) {
+      map.insert(id, static_cast<int>(id));
+      if (id % 8 == 0) {
+        for (std::uint64_t gone{ id - 7 }; gone <= id; ++gone) {
+          REQUIRE(map.erase(gone));
+        }
+      }
+    }
+
+    THEN("its capacity follows the ids held, not the range of ids")
+    {
+      REQUIRE(map.size() <= 8);
+      REQUIRE(map.capacity() <= 32);
+      REQUIRE(*map.find(0) == -1);
+    }
+  }
+}
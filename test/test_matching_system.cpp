@@ -0,0 +1,373 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/matching_system.hpp"
+
+SCENARIO("FIFO MatchingSystem fills by volume in time priority",
+         "[matching_system]")
+{
+  using namespace leyval;
+  OrderBook ob{};
+  MatchingSystem fifo{ FifoMatching{} };
+  constexpr int TAKER_ID{ 0 };
+
+  auto insert_ask = [&](int agent_id, int volume, Money price) {
+    return ob.insert(LimitOrderReq{ .volume = volume,
+                                    .agent_id = agent_id,
+                                    .price = price,
+                                    .order_dir = OrderDir::Ask });
+  };
+
+  GIVEN("a best Ask level of 20, 50, 30 and a worse level of 10")
+  {
+    insert_ask(1, 20, 31);
+    insert_ask(2, 50, 31);
+    insert_ask(3, 30, 31);
+    insert_ask(4, 10, 32);
+
+    WHEN("a Bid MarketOrderReq of 25 arrives")
+    {
+      const auto trans_reqs{ fifo(
+        MarketOrderReq{
+          .volume = 25, .agent_id = TAKER_ID, .order_dir = OrderDir::Bid },
+        ob) };
+
+      THEN("the earliest order is filled and the next is partially filled")
+      {
+        REQUIRE(trans_reqs.size() == 2);
+        REQUIRE(trans_reqs[0].asker_id == 1);
+        REQUIRE(trans_reqs[0].volume == 20);
+        REQUIRE(trans_reqs[1].asker_id == 2);
+        REQUIRE(trans_reqs[1].volume == 5);
+        REQUIRE(trans_reqs[1].bidder_id == TAKER_ID);
+        REQUIRE(trans_reqs[1].price == Money{ 31 });
+        REQUIRE(trans_reqs[0].resting_order_id == 0);
+        REQUIRE(trans_reqs[1].resting_order_id == 1);
+
+        auto [first, last]{ ob.orders_at_best_price(OrderDir::Ask) };
+        REQUIRE(std::distance(first, last) == 2);
+        REQUIRE(first->second.agent_id == 2);
+        REQUIRE(first->second.volume == 45);
+      }
+    }
+
+    WHEN("a Bid MarketOrderReq larger than the best level arrives")
+    {
+      const auto trans_reqs{ fifo(
+        MarketOrderReq{
+          .volume = 105, .agent_id = TAKER_ID, .order_dir = OrderDir::Bid },
+        ob) };
+
+      THEN("it sweeps into the next level")
+      {
+        REQUIRE(trans_reqs.size() == 4);
+        REQUIRE(trans_reqs[3].asker_id == 4);
+        REQUIRE(trans_reqs[3].volume == 5);
+        REQUIRE(trans_reqs[3].price == Money{ 32 });
+        REQUIRE(ob.orders_at_best_price(OrderDir::Ask).first->second.volume ==
+                5);
+      }
+    }
+
+    WHEN("a Bid MarketOrderReq larger than the whole side arrives")
+    {
+      const auto trans_reqs{ fifo(
+        MarketOrderReq{
+          .volume = 200, .agent_id = TAKER_ID, .order_dir = OrderDir::Bid },
+        ob) };
+
+      THEN("everything is filled and the rest is dropped")
+      {
+        REQUIRE(trans_reqs.size() == 4);
+        REQUIRE(ob.empty(OrderDir::Ask));
+      }
+    }
+  }
+}
+
+SCENARIO("Pro-rata MatchingSystem allocates by weight at the best level",
+         "[matching_system]")
+{
+  using namespace leyval;
+  OrderBook ob{};
+  MatchingSystem pro_rata{ ProRataMatching{} };
+  constexpr int TAKER_ID{ 0 };
+
+  auto insert_ask = [&](int agent_id, int volume, Money price) {
+    return ob.insert(LimitOrderReq{ .volume = volume,
+                                    .agent_id = agent_id,
+                                    .price = price,
+                                    .order_dir = OrderDir::Ask });
+  };
+
+  GIVEN("a best Ask level of 20, 50, 30 (as in the README)")
+  {
+    insert_ask(1, 20, 31);
+    insert_ask(2, 50, 31);
+    insert_ask(3, 30, 31);
+    insert_ask(4, 10, 32);
+
+    WHEN("a Bid MarketOrderReq of 25 arrives")
+    {
+      const auto trans_reqs{ pro_rata(
+        MarketOrderReq{
+          .volume = 25, .agent_id = TAKER_ID, .order_dir = OrderDir::Bid },
+        ob) };
+
+      THEN("shares are split 5, 13, 7, rounding up by FIFO priority")
+      {
+        REQUIRE(trans_reqs.size() == 3);
+        REQUIRE(trans_reqs[0].volume == 5);
+        REQUIRE(trans_reqs[1].volume == 13);
+        REQUIRE(trans_reqs[2].volume == 7);
+
+        auto [first, last]{ ob.orders_at_best_price(OrderDir::Ask) };
+        REQUIRE(first->second.volume == 15);
+        REQUIRE(std::next(first)->second.volume == 37);
+        REQUIRE(std::next(first, 2)->second.volume == 23);
+      }
+    }
+
+    WHEN("a Bid MarketOrderReq larger than the best level arrives")
+    {
+      const auto trans_reqs{ pro_rata(
+        MarketOrderReq{
+          .volume = 104, .agent_id = TAKER_ID, .order_dir = OrderDir::Bid },
+        ob) };
+
+      THEN("the level is taken and the rest is allocated at the next")
+      {
+        REQUIRE(trans_reqs.size() == 4);
+        REQUIRE(trans_reqs[3].price == Money{ 32 });
+        REQUIRE(trans_reqs[3].volume == 4);
+        REQUIRE(ob.get_state().num_orders_ask == 1);
+      }
+    }
+  }
+}
+
+SCENARIO("pro_rata_allocate hands leftover shares out FIFO",
+         "[matching_system]")
+{
+  using namespace leyval;
+  LevelVolumes level{};
+
+  GIVEN("equal resting volumes")
+  {
+    level.resize(3);
+    level.volume = { 1, 1, 1 };
+
+    THEN("the earliest orders get the leftover shares")
+    {
+      pro_rata_allocate(2, level);
+      REQUIRE(level.alloc == std::vector<int>{ 1, 1, 0 });
+    }
+  }
+
+  GIVEN("an order whose allocation is exact")
+  {
+    level.resize(3);
+    level.volume = { 10, 3, 7 };
+
+    THEN("it does not take part in the leftover")
+    {
+      // 5, 1.5, 3.5
+      pro_rata_allocate(10, level);
+      REQUIRE(level.alloc == std::vector<int>{ 5, 2, 3 });
+    }
+  }
+}
+
+SCENARIO("Random selection MatchingSystem draws shares at the best level",
+         "[matching_system]")
+{
+  using namespace leyval;
+  constexpr int TAKER_ID{ 0 };
+
+  auto make_book = []() {
+    OrderBook ob{};
+    for (const auto& [agent_id, volume] :
+         { std::pair{ 1, 20 }, std::pair{ 2, 50 }, std::pair{ 3, 30 } }) {
+      ob.insert(LimitOrderReq{ .volume = volume,
+                               .agent_id = agent_id,
+                               .price = 31,
+                               .order_dir = OrderDir::Ask });
+    }
+    return ob;
+  };
+  const MarketOrderReq mor{ .volume = 25,
+                            .agent_id = TAKER_ID,
+                            .order_dir = OrderDir::Bid };
+
+  auto volumes_by_agent = [](const std::vector<TransactionRequest>& reqs) {
+    std::vector<std::pair<int, int>> res;
+    for (const auto& req : reqs) {
+      res.emplace_back(req.asker_id, req.volume);
+    }
+    return res;
+  };
+
+  GIVEN("a volume weighted RSS")
+  {
+    MatchingSystem rss{ RandomSelectionMatching{} };
+    OrderBook ob{ make_book() };
+    const auto trans_reqs{ rss(mor, ob) };
+
+    THEN("every share is allocated, one TransactionRequest per order")
+    {
+      int total{ 0 };
+      for (const auto& req : trans_reqs) {
+        REQUIRE(req.bidder_id == TAKER_ID);
+        total += req.volume;
+      }
+      REQUIRE(total == 25);
+      REQUIRE(trans_reqs.size() <= 3);
+
+      int resting{ 0 };
+      auto [first, last]{ ob.orders_at_best_price(OrderDir::Ask) };
+      for (auto it{ first }; it != last; ++it) {
+        resting += it->second.volume;
+      }
+      REQUIRE(resting == 75);
+    }
+  }
+
+  GIVEN("two RSS with the same seed")
+  {
+    MatchingSystem rss1{ RandomSelectionMatching{ RssWeight::uniform, 42 } };
+    MatchingSystem rss2{ RandomSelectionMatching{ RssWeight::uniform, 42 } };
+    OrderBook ob1{ make_book() };
+    OrderBook ob2{ make_book() };
+
+    THEN("they allocate identically")
+    {
+      REQUIRE(volumes_by_agent(rss1(mor, ob1)) ==
+              volumes_by_agent(rss2(mor, ob2)));
+    }
+  }
+
+  GIVEN("a book that has changed since RSS first drew from it")
+  {
+    for (const RssWeight weight : { RssWeight::volume, RssWeight::uniform }) {
+      OrderBook changed{ make_book() };
+      MatchingSystem first{ RandomSelectionMatching{ weight, 1 } };
+      first(
+        MarketOrderReq{
+          .volume = 5, .agent_id = TAKER_ID, .order_dir = OrderDir::Bid },
+        changed);
+      for (const auto& [agent_id, volume] :
+           { std::pair{ 4, 40 }, std::pair{ 5, 0 }, std::pair{ 6, 10 } }) {
+        changed.insert(LimitOrderReq{ .volume = volume,
+                                      .agent_id = agent_id,
+                                      .price = 31,
+                                      .order_dir = OrderDir::Ask });
+      }
+      changed.remove_earliest_order(2, OrderDir::Ask);
+      changed.remove_earliest_order(1, OrderDir::Ask);
+      changed.insert(LimitOrderReq{
+        .volume = 15, .agent_id = 7, .price = 31, .order_dir = OrderDir::Ask });
+
+      // The same queue, built from scratch
+      OrderBook fresh{};
+      auto [first_it, last_it]{ changed.orders_at_best_price(OrderDir::Ask) };
+      for (auto it{ first_it }; it != last_it; ++it) {
+        fresh.insert(LimitOrderReq{ .volume = it->second.volume,
+                                    .agent_id = it->second.agent_id,
+                                    .price = 31,
+                                    .order_dir = OrderDir::Ask });
+      }
+
+      THEN("its kept weights draw as weights built from scratch")
+      {
+        MatchingSystem rss1{ RandomSelectionMatching{ weight, 42 } };
+        MatchingSystem rss2{ RandomSelectionMatching{ weight, 42 } };
+        REQUIRE(volumes_by_agent(rss1(mor, changed)) ==
+                volumes_by_agent(rss2(mor, fresh)));
+        REQUIRE(changed.get_state().volume_ask ==
+                fresh.get_state().volume_ask);
+      }
+    }
+  }
+
+  GIVEN("a weighted level with most of its orders cancelled, then one added")
+  {
+    OrderBook ob{};
+    for (const int agent_id : { 1, 2, 3, 4 }) {
+      ob.insert(LimitOrderReq{ .volume = 10,
+                               .agent_id = agent_id,
+                               .price = 31,
+                               .order_dir = OrderDir::Ask });
+    }
+    [[maybe_unused]] const auto& enabled{ ob.best_level_weights(
+      OrderDir::Ask) };
+    for (const int agent_id : { 1, 2, 3 }) {
+      ob.remove_earliest_order(agent_id, OrderDir::Ask);
+    }
+    ob.insert(LimitOrderReq{
+      .volume = 10, .agent_id = 5, .price = 31, .order_dir = OrderDir::Ask });
+
+    THEN("each resting order is weighed once, before and after an RSS fill")
+    {
+      const std::int64_t total{
+        ob.best_level_weights(OrderDir::Ask).volume.total()
+      };
+      REQUIRE(total == 20);
+      REQUIRE(ob.best_level_weights(OrderDir::Ask).count.total() == 2);
+
+      MatchingSystem rss{ RandomSelectionMatching{ RssWeight::volume, 7 } };
+      rss(MarketOrderReq{
+            .volume = 15, .agent_id = TAKER_ID, .order_dir = OrderDir::Bid },
+          ob);
+      const std::int64_t left{
+        ob.best_level_weights(OrderDir::Ask).volume.total()
+      };
+      REQUIRE(left == 5);
+      REQUIRE(ob.get_state().volume_ask == 5);
+    }
+  }
+
+  GIVEN("a uniform RSS and a single share to fill, many times")
+  {
+    MatchingSystem rss{ RandomSelectionMatching{ RssWeight::uniform } };
+    std::array<int, 4> hits{};
+    for ([[maybe_unused]] const int _ : std::views::iota(0, 3000)) {
+      OrderBook ob{ make_book() };
+      const auto trans_reqs{ rss(
+        MarketOrderReq{
+          .volume = 1, .agent_id = TAKER_ID, .order_dir = OrderDir::Bid },
+        ob) };
+      ++hits.at(trans_reqs.at(0).asker_id);
+    }
+
+    THEN("each order is picked about equally often, regardless of volume")
+    {
+      for (const int agent_id : { 1, 2, 3 }) {
+        REQUIRE(hits[agent_id] > 850);
+        REQUIRE(hits[agent_id] < 1150);
+      }
+    }
+  }
+}
+
+SCENARIO("MatchingType round trips through its name", "[matching_system]")
+{
+  using namespace leyval;
+
+  THEN("every MatchingSystem's type string parses back to its type")
+  {
+    REQUIRE(matching_type_from_string(
+              MatchingSystem<FifoMatching>::get_type_string()) ==
+            MatchingType::fifo);
+    REQUIRE(matching_type_from_string(
+              MatchingSystem<ProRataMatching>::get_type_string()) ==
+            MatchingType::pro_rata);
+    REQUIRE(matching_type_from_string(
+              MatchingSystem<RandomSelectionMatching>::get_type_string()) ==
+            MatchingType::random_selection);
+  }
+
+  THEN("an unknown name throws")
+  {
+    REQUIRE_THROWS_AS(matching_type_from_string("LIFO"),
+                      std::invalid_argument);
+  }
+}
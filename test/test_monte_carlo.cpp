@@ -0,0 +1,57 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <map>
+#include <random>
+
+#include "../src/monte_carlo.hpp"
+
+SCENARIO("RunningStats summarises a stream of values", "[monte_carlo]")
+{
+  using namespace leyval;
+  RunningStats stats{};
+
+  for (const double x : { 2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0 }) {
+    stats.add(x);
+  }
+
+  THEN("it has the mean, sample variance and range of every value added")
+  {
+    REQUIRE(stats.count() == 8);
+    REQUIRE(stats.mean() == 5.0);
+    REQUIRE(stats.variance() == 32.0 / 7);
+    REQUIRE(stats.min() == 2.0);
+    REQUIRE(stats.max() == 9.0);
+  }
+}
+
+SCENARIO("Monte Carlo replications are independent of scheduling",
+         "[monte_carlo]")
+{
+  using namespace leyval;
+  using PRNG = std::mt19937;
+
+  auto runs_by_replication = [](std::size_t num_threads) {
+    const MonteCarloConfig config{ .num_replications = 6,
+                                   .num_ticks = 5,
+                                   .seed = 7,
+                                   .num_threads = num_threads };
+    std::map<int, std::int64_t> traded_volumes;
+    const MonteCarloSummary summary{ run_monte_carlo<PRNG>(
+      config, [&](const RunSummary& run) {
+        traded_volumes[run.replication] = run.traded_volume;
+      }) };
+    REQUIRE(summary.traded_volume.count() == 6);
+    return traded_volumes;
+  };
+
+  GIVEN("the same seed")
+  {
+    const auto serial{ runs_by_replication(1) };
+
+    THEN("every replication ends the same on any number of threads")
+    {
+      REQUIRE(serial.size() == 6);
+      REQUIRE(runs_by_replication(3) == serial);
+    }
+  }
+}
@@ -1,5 +1,7 @@
 #include <catch2/catch_test_macros.hpp>
 
+#include <stdexcept>
+
 #include "../src/order_book.hpp"
 
 SCENARIO("OrderBook is essentially a wrapper over Ask/BidContainer",
@@ -13,7 +15,7 @@ SCENARIO("OrderBook is essentially a wrapper over Ask/BidContainer",
   {
     THEN("the size of both Ask/BidContainer starts at 0")
     {
-      REQUIRE(ob.update_get_state().num_orders_ask == 0);
+      REQUIRE(ob.get_state().num_orders_ask == 0);
     }
   }
 
@@ -26,7 +28,7 @@ SCENARIO("OrderBook is essentially a wrapper over Ask/BidContainer",
 
     THEN("The corresponding container size increments")
     {
-      REQUIRE(ob.update_get_state().num_orders_ask == 1);
+      REQUIRE(ob.get_state().num_orders_ask == 1);
 
       WHEN("remove_earliest_order() is called")
       {
@@ -34,7 +36,7 @@ SCENARIO("OrderBook is essentially a wrapper over Ask/BidContainer",
 
         THEN("The size reverts back to 0")
         {
-          REQUIRE(ob.update_get_state().num_orders_ask == 0);
+          REQUIRE(ob.get_state().num_orders_ask == 0);
 
           WHEN("remove_earliest_order() is called again")
           {
@@ -48,3 +50,419 @@ SCENARIO("OrderBook is essentially a wrapper over Ask/BidContainer",
     }
   }
 }
+
+SCENARIO("OrderBook keeps price levels in a ladder", "[order_book]")
+{
+  using namespace leyval;
+  OrderBook ob{};
+
+  GIVEN("orders on both sides at several prices")
+  {
+    for (const int price : { 95'00, 97'00, 96'00 }) {
+      ob.insert(LimitOrderReq{ .volume = 1,
+                               .agent_id = 1,
+                               .price = price,
+                               .order_dir = OrderDir::Bid });
+    }
+    for (const int price : { 104'00, 102'00, 103'00 }) {
+      ob.insert(LimitOrderReq{ .volume = 1,
+                               .agent_id = 2,
+                               .price = price,
+                               .order_dir = OrderDir::Ask });
+    }
+
+    THEN("the best prices are the highest Bid and the lowest Ask")
+    {
+      const OrderBook::State state{ ob.get_state() };
+      REQUIRE(state.best_price_bid == Money{ 97'00 });
+      REQUIRE(state.best_price_ask == Money{ 102'00 });
+      REQUIRE(state.abs_spread == Money{ 5'00 });
+    }
+
+    WHEN("the best level is emptied")
+    {
+      auto [first, last]{ ob.orders_at_best_price(OrderDir::Ask) };
+      REQUIRE(std::distance(first, last) == 1);
+      ob.remove_order(first, OrderDir::Ask);
+
+      THEN("the next level becomes best")
+      {
+        REQUIRE(ob.get_state().best_price_ask == Money{ 103'00 });
+      }
+    }
+
+    WHEN("a price beyond the initial ladder is inserted")
+    {
+      ob.insert(LimitOrderReq{ .volume = 1,
+                               .agent_id = 2,
+                               .price = 1'000'00,
+                               .order_dir = OrderDir::Bid });
+
+      THEN("the ladder grows to hold it")
+      {
+        REQUIRE(ob.get_state().best_price_bid == Money{ 1'000'00 });
+      }
+    }
+
+    WHEN("a price below the initial ladder is inserted")
+    {
+      ob.insert(LimitOrderReq{
+        .volume = 1, .agent_id = 1, .price = -5, .order_dir = OrderDir::Bid });
+
+      THEN("the ladder grows downwards and keeps the best price")
+      {
+        REQUIRE(ob.get_state().best_price_bid == Money{ 97'00 });
+        REQUIRE(ob.get_state().num_orders_bid == 4);
+      }
+    }
+  }
+
+  GIVEN("several orders at the same price")
+  {
+    for (const int agent_id : { 3, 4, 5 }) {
+      ob.insert(LimitOrderReq{ .volume = agent_id,
+                               .agent_id = agent_id,
+                               .price = 101'00,
+                               .order_dir = OrderDir::Ask });
+    }
+
+    THEN("the level is in time priority")
+    {
+      auto [first, last]{ ob.orders_at_best_price(OrderDir::Ask) };
+      REQUIRE(std::distance(first, last) == 3);
+      REQUIRE(first->second.agent_id == 3);
+      REQUIRE(std::next(first, 2)->second.agent_id == 5);
+    }
+
+    WHEN("an order in the middle of the queue is removed")
+    {
+      REQUIRE(ob.remove_earliest_order(4, OrderDir::Ask));
+
+      THEN("the remaining orders keep their priority")
+      {
+        auto [first, last]{ ob.orders_at_best_price(OrderDir::Ask) };
+        REQUIRE(std::distance(first, last) == 2);
+        REQUIRE(first->second.agent_id == 3);
+        REQUIRE(std::next(first)->second.agent_id == 5);
+      }
+    }
+  }
+}
+
+SCENARIO("OrderBook indexes resting orders by OrderId and agent_id",
+         "[order_book]")
+{
+  using namespace leyval;
+  OrderBook ob{};
+  constexpr int AGENT_ID{ 7 };
+  constexpr int OTHER_AGENT_ID{ 8 };
+
+  auto insert_bid = [&](int agent_id, int volume, Money price) {
+    return ob.insert(LimitOrderReq{ .volume = volume,
+                                    .agent_id = agent_id,
+                                    .price = price,
+                                    .order_dir = OrderDir::Bid });
+  };
+
+  const OrderId first_id{ insert_bid(AGENT_ID, 1, 99'00) };
+  const OrderId second_id{ insert_bid(AGENT_ID, 2, 98'00) };
+  insert_bid(OTHER_AGENT_ID, 3, 99'00);
+
+  THEN("every insert gets a distinct OrderId")
+  {
+    REQUIRE(first_id != second_id);
+  }
+
+  THEN("orders of an agent are in time priority across levels")
+  {
+    auto agent_orders{ ob.orders_at_agentid(AGENT_ID, OrderDir::Bid) };
+    REQUIRE(std::ranges::distance(agent_orders) == 2);
+    REQUIRE(agent_orders.front().second.order_id == first_id);
+  }
+
+  WHEN("remove_specific_order() is called by another agent")
+  {
+    THEN("nothing is removed")
+    {
+      REQUIRE_FALSE(
+        ob.remove_specific_order(OTHER_AGENT_ID, second_id, OrderDir::Bid));
+      REQUIRE(ob.get_state().num_orders_bid == 3);
+    }
+  }
+
+  WHEN("remove_specific_order() is called by the owner")
+  {
+    REQUIRE(ob.remove_specific_order(AGENT_ID, second_id, OrderDir::Bid));
+
+    THEN("only that order is removed")
+    {
+      REQUIRE(ob.get_state().num_orders_bid == 2);
+      REQUIRE_FALSE(
+        ob.remove_specific_order(AGENT_ID, second_id, OrderDir::Bid));
+    }
+  }
+
+  WHEN("remove_earliest_order() is called")
+  {
+    REQUIRE(ob.remove_earliest_order(AGENT_ID, OrderDir::Bid));
+
+    THEN("the agent's earliest order is removed, leaving others in place")
+    {
+      auto agent_orders{ ob.orders_at_agentid(AGENT_ID, OrderDir::Bid) };
+      REQUIRE(std::ranges::distance(agent_orders) == 1);
+      REQUIRE(agent_orders.front().second.order_id == second_id);
+
+      auto [first, last]{ ob.orders_at_best_price(OrderDir::Bid) };
+      REQUIRE(std::distance(first, last) == 1);
+      REQUIRE(first->second.agent_id == OTHER_AGENT_ID);
+    }
+  }
+
+  WHEN("many later orders come and go on both sides")
+  {
+    for (int i{ 0 }; i < 1000; ++i) {
+      const OrderId bid_id{ insert_bid(OTHER_AGENT_ID, 1, 97'00) };
+      const OrderId ask_id{ ob.insert(LimitOrderReq{
+        .volume = 1,
+        .agent_id = OTHER_AGENT_ID,
+        .price = 101'00,
+        .order_dir = OrderDir::Ask }) };
+      REQUIRE(ob.remove_specific_order(OTHER_AGENT_ID, bid_id, OrderDir::Bid));
+      if (i % 2 == 0) {
+        REQUIRE(
+          ob.remove_specific_order(OTHER_AGENT_ID, ask_id, OrderDir::Ask));
+      }
+    }
+
+    THEN("the orders still resting are found by OrderId")
+    {
+      REQUIRE(ob.get_state().num_orders_ask == 500);
+      REQUIRE(ob.remove_specific_order(AGENT_ID, second_id, OrderDir::Bid));
+      REQUIRE(ob.remove_specific_order(AGENT_ID, first_id, OrderDir::Bid));
+      REQUIRE(ob.get_state().num_orders_bid == 1);
+    }
+  }
+}
+
+SCENARIO("OrderBook keeps its State current", "[order_book]")
+{
+  using namespace leyval;
+  OrderBook ob{};
+
+  ob.insert(LimitOrderReq{
+    .volume = 5, .agent_id = 1, .price = 99'00, .order_dir = OrderDir::Bid });
+  ob.insert(LimitOrderReq{
+    .volume = 4, .agent_id = 2, .price = 101'00, .order_dir = OrderDir::Ask });
+  const OrderId ask_id{ ob.insert(LimitOrderReq{ .volume = 6,
+                                                 .agent_id = 2,
+                                                 .price = 102'00,
+                                                 .order_dir = OrderDir::Ask }) };
+
+  THEN("it reflects every insert without being asked to update")
+  {
+    const OrderBook::State& state{ ob.get_state() };
+    REQUIRE(state.best_price_bid == Money{ 99'00 });
+    REQUIRE(state.best_price_ask == Money{ 101'00 });
+    REQUIRE(state.mid_price == Money{ 100'00 });
+    // 2 / 100, in %
+    const float quoted_spread{ state.quoted_spread };
+    REQUIRE(1.99F < quoted_spread);
+    REQUIRE(quoted_spread < 2.01F);
+    REQUIRE(state.volume_bid == 5);
+    REQUIRE(state.volume_ask == 10);
+    REQUIRE(state.imbalance == -1.0F / 3);
+  }
+
+  WHEN("the best Ask is partially, then fully filled")
+  {
+    auto order_it{ ob.orders_at_best_price(OrderDir::Ask).first };
+    order_it = ob.fill_order(order_it, OrderDir::Ask, 3);
+    REQUIRE(ob.get_state().volume_ask == 7);
+    REQUIRE(ob.get_state().best_price_ask == Money{ 101'00 });
+
+    ob.fill_order(order_it, OrderDir::Ask, 1);
+
+    THEN("volume and best price follow each fill")
+    {
+      REQUIRE(ob.get_state().volume_ask == 6);
+      REQUIRE(ob.get_state().num_orders_ask == 1);
+      REQUIRE(ob.get_state().best_price_ask == Money{ 102'00 });
+    }
+  }
+
+  WHEN("an order is cancelled")
+  {
+    REQUIRE(ob.remove_specific_order(2, ask_id, OrderDir::Ask));
+
+    THEN("its volume leaves the State")
+    {
+      REQUIRE(ob.get_state().volume_ask == 4);
+      REQUIRE(ob.get_state().num_orders_ask == 1);
+    }
+  }
+  WHEN("the best Bid is at or below 0")
+  {
+    ob.remove_earliest_order(1, OrderDir::Bid);
+    ob.insert(LimitOrderReq{
+      .volume = 2, .agent_id = 3, .price = -1'00, .order_dir = OrderDir::Bid });
+    const OrderId bid_id{ ob.insert(LimitOrderReq{
+      .volume = 1, .agent_id = 3, .price = -2'00, .order_dir = OrderDir::Bid }) };
+
+    THEN("the State still follows the book")
+    {
+      REQUIRE(bid_id == ask_id + 2);
+      REQUIRE(ob.get_state().best_price_bid == Money{ -1'00 });
+      REQUIRE(ob.get_state().num_orders_bid == 2);
+
+      auto order_it{ ob.orders_at_best_price(OrderDir::Bid).first };
+      ob.fill_order(order_it, OrderDir::Bid, 2);
+      REQUIRE(ob.get_state().best_price_bid == Money{ -2'00 });
+      REQUIRE(ob.get_state().volume_bid == 1);
+    }
+  }
+}
+
+SCENARIO("OrderBook gives the top levels of depth", "[order_book]")
+{
+  using namespace leyval;
+  OrderBook ob{};
+
+  for (const auto& [volume, price] :
+       { std::pair{ 2, 98'00 }, { 3, 99'00 }, { 4, 99'00 }, { 1, 95'00 } }) {
+    ob.insert(LimitOrderReq{ .volume = volume,
+                             .agent_id = 1,
+                             .price = price,
+                             .order_dir = OrderDir::Bid });
+  }
+  ob.insert(LimitOrderReq{
+    .volume = 5, .agent_id = 2, .price = 101'00, .order_dir = OrderDir::Ask });
+
+  WHEN("fewer levels are asked for than exist")
+  {
+    const DepthSnapshot<2> depth{ ob.depth<2>() };
+
+    THEN("only the best are given, best first, with cumulative volume")
+    {
+      REQUIRE(depth.num_levels_bid == 2);
+      REQUIRE(depth.bids[0].price == Money{ 99'00 });
+      REQUIRE(depth.bids[0].num_orders == 2);
+      REQUIRE(depth.bids[0].volume == 7);
+      REQUIRE(depth.bids[1].price == Money{ 98'00 });
+      REQUIRE(depth.bids[1].cumulative_volume == 9);
+    }
+  }
+
+  WHEN("more levels are asked for than exist")
+  {
+    const DepthSnapshot<4> depth{ ob.depth<4>() };
+
+    THEN("only the existing levels are meaningful")
+    {
+      REQUIRE(depth.bid_levels().size() == 3);
+      REQUIRE(depth.bid_levels().back().price == Money{ 95'00 });
+      REQUIRE(depth.ask_levels().size() == 1);
+      REQUIRE(depth.asks[0].volume == 5);
+    }
+  }
+
+  WHEN("an order at the best level is partially filled")
+  {
+    ob.fill_order(
+      ob.orders_at_best_price(OrderDir::Bid).first, OrderDir::Bid, 2);
+
+    THEN("the level volume follows")
+    {
+      REQUIRE(ob.depth<1>().bids[0].volume == 5);
+      REQUIRE(ob.depth<1>().bids[0].num_orders == 2);
+    }
+  }
+}
+
+SCENARIO("An OrderBook only rests orders on its price grid", "[order_book]")
+{
+  using namespace leyval;
+  OrderBook ob{ PriceGrid{ Money{ 100'00 }, Money{ 25 } } };
+
+  ob.insert({ .volume = 3,
+              .agent_id = 0,
+              .price = 99'75,
+              .order_dir = OrderDir::Bid });
+  ob.insert({ .volume = 4,
+              .agent_id = 0,
+              .price = 99'50,
+              .order_dir = OrderDir::Bid });
+
+  WHEN("an order is priced between ticks")
+  {
+    THEN("it is rejected, and the book is left as it was")
+    {
+      REQUIRE_THROWS_AS(ob.insert({ .volume = 1,
+                                    .agent_id = 1,
+                                    .price = 99'60,
+                                    .order_dir = OrderDir::Bid }),
+                        std::domain_error);
+      REQUIRE(ob.get_state().num_orders_bid == 2);
+      REQUIRE(ob.get_state().volume_bid == 7);
+      REQUIRE(ob.insert({ .volume = 1,
+                          .agent_id = 1,
+                          .price = 99'50,
+                          .order_dir = OrderDir::Bid }) == 2);
+    }
+  }
+
+  WHEN("an order is priced beyond the grid's span")
+  {
+    THEN("it is rejected before the ladder grows to it")
+    {
+      REQUIRE_THROWS_AS(ob.insert({ .volume = 1,
+                                    .agent_id = 1,
+                                    .price = 1'000'000'00,
+                                    .order_dir = OrderDir::Ask }),
+                        std::domain_error);
+      REQUIRE(ob.empty(OrderDir::Ask));
+      REQUIRE(ob.insert({ .volume = 1,
+                          .agent_id = 1,
+                          .price = 101'00,
+                          .order_dir = OrderDir::Ask }) == 2);
+    }
+  }
+
+  WHEN("orders are priced far below the reference price")
+  {
+    const OrderId order_id{ ob.insert({ .volume = 5,
+                                        .agent_id = 1,
+                                        .price = 1'00,
+                                        .order_dir = OrderDir::Bid }) };
+
+    REQUIRE(order_id == 2);
+
+    THEN("levels are still reported by their Money price, best first")
+    {
+      const DepthSnapshot<3> depth{ ob.depth<3>() };
+      REQUIRE(depth.bid_levels().size() == 3);
+      REQUIRE(depth.bids[0].price == Money{ 99'75 });
+      REQUIRE(depth.bids[1].price == Money{ 99'50 });
+      REQUIRE(depth.bids[2].price == Money{ 1'00 });
+      REQUIRE(depth.bids[2].cumulative_volume == 12);
+    }
+  }
+
+  WHEN("the grid only spans a few ticks")
+  {
+    OrderBook narrow{ PriceGrid{ Money{ 100'00 }, Money{ 25 }, 4 } };
+    for (const int price : { 99'00, 99'75, 101'00 }) {
+      narrow.insert({ .volume = 1,
+                      .agent_id = 1,
+                      .price = price,
+                      .order_dir = OrderDir::Bid });
+    }
+
+    THEN("orders rest up to both ends of it")
+    {
+      REQUIRE(narrow.get_state().num_orders_bid == 3);
+      const DepthSnapshot<3> depth{ narrow.depth<3>() };
+      REQUIRE(depth.bids[0].price == Money{ 101'00 });
+      REQUIRE(depth.bids[2].price == Money{ 99'00 });
+    }
+  }
+}
@@ -0,0 +1,106 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "../src/agent.hpp"
+#include "../src/util/philox.hpp"
+
+SCENARIO("Philox4x32 matches the reference implementation", "[philox]")
+{
+  using leyval::Philox4x32;
+  using Words = std::array<std::uint32_t, 4>;
+
+  // Known answers of Random123's philox4x32_10
+  REQUIRE(Philox4x32::generate({ 0, 0, 0, 0 }, { 0, 0 }) ==
+          Words{ 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 });
+  REQUIRE(Philox4x32::generate(
+            { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff },
+            { 0xffffffff, 0xffffffff }) ==
+          Words{ 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd });
+  REQUIRE(Philox4x32::generate(
+            { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 },
+            { 0xa4093822, 0x299f31d0 }) ==
+          Words{ 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 });
+
+  GIVEN("a stream of key and stream id 0")
+  {
+    Philox4x32 rng{ 0, 0 };
+
+    THEN("it outputs block 0, then block 1")
+    {
+      const Words block0{ Philox4x32::generate({ 0, 0, 0, 0 }, { 0, 0 }) };
+      const Words block1{ Philox4x32::generate({ 1, 0, 0, 0 }, { 0, 0 }) };
+      for (const std::uint32_t word : block0) {
+        REQUIRE(rng() == word);
+      }
+      REQUIRE(rng() == block1[0]);
+    }
+  }
+}
+
+SCENARIO("Philox4x32 streams can be positioned and split", "[philox]")
+{
+  using leyval::Philox4x32;
+
+  Philox4x32 rng{ 7, 3 };
+  std::vector<std::uint32_t> outputs(40);
+  for (auto& output : outputs) {
+    output = rng();
+  }
+
+  WHEN("outputs are discarded")
+  {
+    THEN("the stream carries on as if they had been drawn")
+    {
+      for (const unsigned long long n : { 0, 1, 3, 4, 5, 13, 32 }) {
+        Philox4x32 skipped{ 7, 3 };
+        skipped();
+        skipped.discard(n);
+        REQUIRE(skipped() == outputs[n + 1]);
+      }
+    }
+  }
+
+  WHEN("a stream seeks a block")
+  {
+    Philox4x32 sought{ 7, 3 };
+    sought();
+    sought.seek(5);
+
+    THEN("it outputs from there")
+    {
+      REQUIRE(sought() == outputs[20]);
+    }
+  }
+
+  WHEN("streams are split off")
+  {
+    Philox4x32 parent{ 7, 0 };
+    const Philox4x32 child{ leyval::split_stream(parent) };
+
+    THEN("they share the key, but not the outputs")
+    {
+      REQUIRE(child.key() == parent.key());
+      REQUIRE(child.stream() != parent.stream());
+      Philox4x32 a{ child };
+      Philox4x32 b{ parent.split(parent.stream()) };
+      REQUIRE(a() != b());
+    }
+  }
+
+  WHEN("seeded from a seed sequence")
+  {
+    std::seed_seq seq1{ 1, 2 };
+    std::seed_seq seq2{ 1, 2 };
+    std::seed_seq seq3{ 1, 3 };
+
+    THEN("equal sequences give equal engines")
+    {
+      REQUIRE(Philox4x32{ seq1 } == Philox4x32{ seq2 });
+      REQUIRE_FALSE(Philox4x32{ seq2 } == Philox4x32{ seq3 });
+    }
+  }
+}
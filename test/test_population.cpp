@@ -0,0 +1,204 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "../src/order_book.hpp"
+#include "../src/population.hpp"
+#include "../src/util/philox.hpp"
+
+namespace {
+leyval::OrderBook
+make_book()
+{
+  using namespace leyval;
+  OrderBook order_book{};
+  for (int i{ 0 }; i < 10; ++i) {
+    order_book.insert({ .volume = 10,
+                        .agent_id = 0,
+                        .price = 990 - i,
+                        .order_dir = OrderDir::Bid });
+    order_book.insert({ .volume = 10,
+                        .agent_id = 0,
+                        .price = 1'010 + i,
+                        .order_dir = OrderDir::Ask });
+  }
+  return order_book;
+}
+
+std::vector<int>
+all_ids(std::size_t n)
+{
+  std::vector<int> ids(n);
+  std::iota(ids.begin(), ids.end(), 0);
+  return ids;
+}
+}
+
+SCENARIO("A Population keeps each agent's state under its id", "[population]")
+{
+  using namespace leyval;
+  using PRNG = std::mt19937;
+
+  PRNG rng{ 3 };
+  Population<PRNG> agents{};
+  for (int i{ 0 }; i < 50; ++i) {
+    REQUIRE(agents.add(AgentType::jf_provider, 1'000 + i, rng) == 2 * i);
+    REQUIRE(agents.add(AgentType::jf_taker, 2'000 + i, rng) == 2 * i + 1);
+  }
+
+  WHEN("agents trade")
+  {
+    agents.sell(0, 5, Money{ 500 });
+    agents.buy(1, 5, Money{ 500 });
+
+    THEN("only the seller and buyer change")
+    {
+      REQUIRE(agents.shares(0) == -5);
+      REQUIRE(agents.capital(0) == Money{ 1'500 });
+      REQUIRE(agents.shares(1) == 5);
+      REQUIRE(agents.capital(1) == Money{ 1'500 });
+      REQUIRE(agents.shares(2) == 0);
+      REQUIRE(agents.capital(2) == Money{ 1'001 });
+    }
+  }
+
+  WHEN("they are shuffled")
+  {
+    agents.shuffle(rng);
+
+    THEN("each agent keeps its type along with its capital")
+    {
+      for (int id{ 0 }; id < static_cast<int>(agents.size()); ++id) {
+        const AgentType type{ agents.capital(id) < Money{ 2'000 }
+                                ? AgentType::jf_provider
+                                : AgentType::jf_taker };
+        REQUIRE(agents.type(id) == type);
+      }
+    }
+  }
+
+  WHEN("they decide in pieces")
+  {
+    const OrderBook::State ob_state{ make_book().get_state() };
+
+    Population<PRNG> copy{ agents };
+    std::vector<OrderReq_t> whole;
+    const std::vector<int> ids{ all_ids(agents.size()) };
+    agents.generate_orders(ob_state, 1, ids, whole);
+    std::vector<OrderReq_t> pieces;
+    const std::span<const int> all{ ids };
+    copy.generate_orders(ob_state, 1, all.first(33), pieces);
+    copy.generate_orders(ob_state, 1, all.subspan(33, 1), pieces);
+    copy.generate_orders(ob_state, 1, all.subspan(34), pieces);
+
+    THEN("they decide as they do all at once")
+    {
+      REQUIRE_FALSE(whole.empty());
+      REQUIRE(pieces == whole);
+    }
+  }
+}
+
+SCENARIO("A counter-based Population decides any tick on its own",
+         "[population]")
+{
+  using namespace leyval;
+  using PRNG = Philox4x32;
+
+  PRNG rng{ 11 };
+  Population<PRNG> agents{};
+  for (int i{ 0 }; i < 20; ++i) {
+    agents.add(AgentType::jf_provider, 1'000, rng);
+    agents.add(AgentType::jf_taker, 1'000, rng);
+  }
+  const OrderBook::State ob_state{ make_book().get_state() };
+  const std::vector<int> ids{ all_ids(agents.size()) };
+  Population<PRNG> copy{ agents };
+
+  GIVEN("one copy that decided ticks 1 to 9, and one that did not")
+  {
+    std::vector<OrderReq_t> reqs;
+    for (std::uint32_t tick{ 1 }; tick < 10; ++tick) {
+      reqs.clear();
+      agents.generate_orders(ob_state, tick, ids, reqs);
+    }
+
+    THEN("both decide tick 10 the same")
+    {
+      std::vector<OrderReq_t> after;
+      agents.generate_orders(ob_state, 10, ids, after);
+      std::vector<OrderReq_t> jumped;
+      copy.generate_orders(ob_state, 10, ids, jumped);
+      REQUIRE_FALSE(after.empty());
+      REQUIRE(jumped == after);
+      REQUIRE(jumped != reqs);
+    }
+  }
+}
+
+SCENARIO("Agents decide at geometric intervals", "[population]")
+{
+  using namespace leyval;
+  using PRNG = std::mt19937;
+
+  PRNG rng{ 12 };
+  Population<PRNG> agents{};
+  const int every_tick{ agents.add(AgentType::jf_taker, 1'000, rng) };
+  const int sparse{ agents.add(AgentType::jf_taker, 1'000, rng, 20) };
+  REQUIRE_THROWS_AS(agents.add(AgentType::jf_taker, 1'000, rng, 0.5),
+                    std::invalid_argument);
+
+  THEN("intervals average mean_interval, and are at least a tick")
+  {
+    REQUIRE(agents.next_decision(every_tick, 7) == 8);
+
+    const int n{ 10'000 };
+    double sum{ 0 };
+    for (int i{ 0 }; i < n; ++i) {
+      const std::uint32_t next{ agents.next_decision(sparse, 7) };
+      REQUIRE(next >= 8);
+      sum += next - 7;
+    }
+    // Geometric with mean 20 has a stddev of about 19.5
+    REQUIRE(std::abs(sum / n - 20) < 5 * 19.5 / 100);
+  }
+}
+
+SCENARIO("Takers' market order volume can be set", "[population]")
+{
+  using namespace leyval;
+  using PRNG = std::mt19937;
+
+  PRNG rng{ 13 };
+  Population<PRNG> agents{};
+  for (int i{ 0 }; i < 200; ++i) {
+    agents.add(AgentType::jf_taker, 1'000, rng);
+  }
+  REQUIRE_THROWS_AS(agents.set_mean_market_volume(0), std::invalid_argument);
+
+  WHEN("the mean is raised")
+  {
+    agents.set_mean_market_volume(50);
+    std::vector<OrderReq_t> reqs;
+    agents.generate_orders(
+      make_book().get_state(), 1, all_ids(agents.size()), reqs);
+
+    THEN("market orders average about the new mean")
+    {
+      REQUIRE_FALSE(reqs.empty());
+      double sum{ 0 };
+      for (const OrderReq_t& req : reqs) {
+        sum += std::get<MarketOrderReq>(req).volume;
+      }
+      // Poisson with mean 50 has a stddev of about 7
+      REQUIRE(std::abs(sum / reqs.size() - 50) < 5 * 7 / std::sqrt(50.0));
+    }
+  }
+}
@@ -0,0 +1,84 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+
+#include "../src/price_tick.hpp"
+
+SCENARIO("A PriceGrid converts between Money and PriceTicks", "[price_tick]")
+{
+  using namespace leyval;
+
+  GIVEN("the default grid")
+  {
+    constexpr PriceGrid grid{};
+
+    THEN("every cent is a tick from 0")
+    {
+      STATIC_REQUIRE(grid.to_tick(Money{ 100'00 }) == PriceTick{ 100'00 });
+      STATIC_REQUIRE(grid.to_money(PriceTick{ -3 }) == Money{ -3 });
+    }
+  }
+
+  GIVEN("a grid of 5 cent ticks around $100")
+  {
+    constexpr PriceGrid grid{ Money{ 100'00 }, Money{ 5 } };
+
+    THEN("prices on the grid round trip")
+    {
+      STATIC_REQUIRE(grid.to_tick(Money{ 100'00 }) == PriceTick{ 0 });
+      STATIC_REQUIRE(grid.to_tick(Money{ 99'95 }) == PriceTick{ -1 });
+      STATIC_REQUIRE(grid.to_tick(Money{ 101'00 }) == PriceTick{ 20 });
+      for (int offset{ -50 }; offset <= 50; ++offset) {
+        REQUIRE(grid.to_tick(grid.to_money({ offset })).offset == offset);
+      }
+    }
+
+    THEN("prices between ticks are rejected")
+    {
+      REQUIRE_THROWS_AS(grid.to_tick(Money{ 100'01 }), std::domain_error);
+      REQUIRE_THROWS_AS(grid.to_tick(Money{ 99'99 }), std::domain_error);
+    }
+
+    THEN("prices beyond its default span are rejected")
+    {
+      constexpr std::int64_t max_offset{ PriceGrid::default_max_offset };
+      REQUIRE(grid.to_tick(Money{ 100'00 - 5 * max_offset }).offset ==
+              -max_offset);
+      REQUIRE_THROWS_AS(grid.to_tick(Money{ 100'00 + 5 * (max_offset + 1) }),
+                        std::domain_error);
+      REQUIRE_THROWS_AS(grid.to_tick(Money{ 100'00 + 5 * (1LL << 31) }),
+                        std::domain_error);
+    }
+  }
+
+  GIVEN("a grid that spans 10 ticks either side")
+  {
+    constexpr PriceGrid grid{ Money{ 100'00 }, Money{ 5 }, 10 };
+
+    THEN("only prices within the span are on it")
+    {
+      STATIC_REQUIRE(grid.to_tick(Money{ 100'50 }) == PriceTick{ 10 });
+      STATIC_REQUIRE(grid.to_tick(Money{ 99'50 }) == PriceTick{ -10 });
+      REQUIRE_THROWS_AS(grid.to_tick(Money{ 100'55 }), std::domain_error);
+      REQUIRE_THROWS_AS(grid.to_tick(Money{ 99'45 }), std::domain_error);
+    }
+  }
+
+  THEN("a tick size must be positive")
+  {
+    REQUIRE_THROWS_AS((PriceGrid{ Money{ 0 }, Money{ 0 } }),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS((PriceGrid{ Money{ 0 }, Money{ -1 } }),
+                      std::invalid_argument);
+  }
+
+  THEN("a span must be non-negative, and small enough to index")
+  {
+    REQUIRE_THROWS_AS((PriceGrid{ Money{ 0 }, Money{ 1 }, -1 }),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(
+      (PriceGrid{ Money{ 0 }, Money{ 1 }, PriceGrid::largest_max_offset + 1 }),
+      std::invalid_argument);
+  }
+}
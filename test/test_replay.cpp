@@ -0,0 +1,119 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <random>
+#include <vector>
+
+#include "../src/event_log.hpp"
+#include "../src/exchange.hpp"
+#include "../src/replay.hpp"
+#include "temp_file.hpp"
+
+namespace {
+using PRNG = std::mt19937;
+
+// Records 20 ticks of an Exchange under policy to path
+template<leyval::MatchingPolicy Policy>
+void
+record_run(const std::filesystem::path& path, Policy policy)
+{
+  using namespace leyval;
+  PRNG rng{ 3 };
+  Population<PRNG> agents{};
+  for (int i{ 0 }; i < 20; ++i) {
+    agents.add(AgentType::jf_provider, 1'000, rng);
+    agents.add(AgentType::jf_taker, 1'000, rng);
+  }
+  Exchange<PRNG, Policy> exch{
+    OrderBook{}, std::move(agents), MatchingSystem{ std::move(policy) }, rng
+  };
+
+  EventLogWriter writer{ path };
+  exch.set_event_log(&writer);
+  exch.saturate();
+  for (int tick{ 0 }; tick < 20; ++tick) {
+    exch.run();
+  }
+}
+
+int
+count_fills(const std::vector<leyval::event_log::Event>& events)
+{
+  int num_fills{ 0 };
+  for (const auto& event : events) {
+    num_fills += event.type == leyval::event_log::EventType::fill ? 1 : 0;
+  }
+  return num_fills;
+}
+}
+
+SCENARIO("Replaying a recorded order stream reproduces its fills",
+         "[replay]")
+{
+  using namespace leyval;
+  const TempFile file{ "test_replay.bin" };
+  const auto& path{ file.path() };
+
+  GIVEN("a run recorded under FIFO")
+  {
+    record_run(path, FifoMatching{});
+    const EventLogReader log{ path };
+    const std::vector<OrderReq_t> order_reqs{ recorded_requests(log) };
+
+    WHEN("it is replayed under FIFO")
+    {
+      const auto events{ replay(MatchingConfig{}, order_reqs) };
+
+      THEN("every request, OrderId and fill is the same")
+      {
+        REQUIRE(count_fills(events) > 0);
+        REQUIRE_FALSE(first_divergence(log, events).has_value());
+      }
+    }
+
+    WHEN("it is replayed under the other policies")
+    {
+      THEN("the same requests are fed through")
+      {
+        for (const MatchingType type :
+             { MatchingType::pro_rata, MatchingType::random_selection }) {
+          const auto events{ replay({ .type = type }, order_reqs) };
+          REQUIRE(events.size() - count_fills(events) == order_reqs.size());
+        }
+      }
+    }
+  }
+
+  GIVEN("a run recorded under RSS")
+  {
+    const MatchingConfig config{ .type = MatchingType::random_selection,
+                                 .rss_weight = RssWeight::uniform,
+                                 .rss_seed = 11 };
+    record_run(path,
+               RandomSelectionMatching{ config.rss_weight, config.rss_seed });
+    const EventLogReader log{ path };
+
+    WHEN("it is replayed with the same seed")
+    {
+      const auto events{ replay(config, recorded_requests(log)) };
+
+      THEN("the random allocation is reproduced too")
+      {
+        REQUIRE_FALSE(first_divergence(log, events).has_value());
+      }
+    }
+
+    WHEN("it is replayed with another seed")
+    {
+      const auto events{ replay({ .type = MatchingType::random_selection,
+                                  .rss_weight = RssWeight::uniform,
+                                  .rss_seed = 12 },
+                                recorded_requests(log)) };
+
+      THEN("it diverges")
+      {
+        REQUIRE(first_divergence(log, events).has_value());
+      }
+    }
+  }
+}
@@ -0,0 +1,77 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <random>
+#include <vector>
+
+#include "../src/exchange.hpp"
+#include "../src/snapshot.hpp"
+#include "temp_file.hpp"
+
+SCENARIO("Snapshots stream one record per tick", "[snapshot]")
+{
+  using namespace leyval;
+  using PRNG = std::mt19937;
+  const TempFile file{ "test_snapshot.bin" };
+  const auto& path{ file.path() };
+
+  PRNG rng{ 1 };
+  Population<PRNG> agents{};
+  // Deciding every 50 ticks on average, so that run() skips ticks
+  agents.add(AgentType::jf_provider, 1'000, rng, 50);
+  agents.add(AgentType::jf_taker, 2'000, rng, 50);
+  Exchange exch{
+    OrderBook{}, std::move(agents), MatchingSystem{ FifoMatching{} }, rng
+  };
+  exch.saturate();
+
+  {
+    SnapshotWriter writer{ path };
+    writer.write(exch);
+    exch.run();
+    exch.run();
+    writer.write(exch);
+  }
+
+  WHEN("the stream is read back")
+  {
+    SnapshotReader reader{ path };
+
+    THEN("it has the agents, and every written tick in order")
+    {
+      REQUIRE(reader.agents().size() == 2);
+      REQUIRE(reader.agents()[1].type == "JFTaker");
+
+      const auto first{ reader.next() };
+      REQUIRE(first.has_value());
+      REQUIRE(first->tick == 0);
+      REQUIRE(first->capital == std::vector<std::int64_t>{ 1'000, 2'000 });
+
+      REQUIRE(first->bids.front().price > first->bids.back().price);
+      REQUIRE(first->asks.front().price < first->asks.back().price);
+
+      const auto second{ reader.next() };
+      REQUIRE(second.has_value());
+      REQUIRE(second->tick == exch.get_tick());
+      REQUIRE(second->tick > 2);
+      int num_orders{ 0 };
+      for (const auto& level : second->bids) {
+        num_orders += level.num_orders;
+      }
+      REQUIRE(num_orders == exch.get_order_book().get_state().num_orders_bid);
+      REQUIRE_FALSE(reader.next().has_value());
+    }
+  }
+
+  WHEN("the last record was cut short, as by a crash")
+  {
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+    SnapshotReader reader{ path };
+
+    THEN("the complete records are still read")
+    {
+      REQUIRE(reader.next().has_value());
+      REQUIRE_FALSE(reader.next().has_value());
+    }
+  }
+}
@@ -0,0 +1,69 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "../src/util/thread_pool.hpp"
+
+SCENARIO("ThreadPool runs every task of a parallel_for", "[thread_pool]")
+{
+  using namespace leyval;
+  ThreadPool pool{ 4 };
+
+  THEN("the calling thread counts towards its size")
+  {
+    REQUIRE(pool.size() == 4);
+  }
+
+  WHEN("parallel_for is called repeatedly")
+  {
+    std::vector<int> hits(1000, 0);
+    std::atomic<int> total{ 0 };
+    for (int round{ 0 }; round < 10; ++round) {
+      pool.parallel_for(hits.size(), [&](std::size_t i) {
+        ++hits[i];
+        ++total;
+      });
+    }
+
+    THEN("each index is run exactly once per call")
+    {
+      REQUIRE(total == 10'000);
+      for (const int h : hits) {
+        REQUIRE(h == 10);
+      }
+    }
+  }
+
+  WHEN("tasks throw")
+  {
+    std::atomic<int> started{ 0 };
+    auto throwing{ [&](std::size_t i) {
+      ++started;
+      if (i % 100 == 7) {
+        throw std::runtime_error("task failed");
+      }
+    } };
+
+    THEN("the exception reaches the caller, and the pool stays usable")
+    {
+      REQUIRE_THROWS_AS(pool.parallel_for(1000, throwing), std::runtime_error);
+      REQUIRE(started < 1000);
+
+      std::atomic<int> total{ 0 };
+      pool.parallel_for(1000, [&](std::size_t) { ++total; });
+      REQUIRE(total == 1000);
+    }
+  }
+
+  WHEN("there are no tasks")
+  {
+    pool.parallel_for(0, [](std::size_t) {});
+
+    THEN("it returns immediately")
+    {
+      SUCCEED();
+    }
+  }
+}
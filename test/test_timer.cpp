@@ -44,20 +44,18 @@ SCENARIO("Timer", "[timer]")
     THEN("the generator is called again,.")
     {
       CumulativeAdd functor{ 2 };
-      Timer t{ functor }; // functor is copied: 0 + 2
+      Timer t{ functor }; // functor is copied: m_gen.val = 0 + 2
       REQUIRE(functor() == 2);
-      REQUIRE_FALSE(t.tick_and_check());
-      REQUIRE(t.tick_and_check());
+      REQUIRE(t.ticks_until_fire() == 2);
 
       t.reset(); // m_gen.val = 2 + 2
-      REQUIRE_FALSE(t.tick_and_check());
-      REQUIRE(t.tick_and_check());
+      REQUIRE(t.ticks_until_fire() == 4);
       REQUIRE(functor() == 4);
 
       t.reset(); // m_gen.val = 4 + 2
-      REQUIRE_FALSE(t.tick_and_check());
-      REQUIRE_FALSE(t.tick_and_check());
-      REQUIRE_FALSE(t.tick_and_check());
+      for (int i{ 0 }; i < 5; ++i) {
+        REQUIRE_FALSE(t.tick_and_check());
+      }
       REQUIRE(t.tick_and_check());
     }
   }
@@ -86,3 +84,35 @@ SCENARIO("Timer", "[timer]")
     }
   }
 }
+
+SCENARIO("Timer skips ahead", "[timer]")
+{
+  using namespace leyval;
+
+  GIVEN("a timer of 5 ticks")
+  {
+    Timer t{ 5u };
+    REQUIRE(t.ticks_until_fire() == 5);
+
+    WHEN("it advances by fewer ticks than are left")
+    {
+      REQUIRE_FALSE(t.advance(3));
+
+      THEN("it fires exactly on the rest")
+      {
+        REQUIRE(t.ticks_until_fire() == 2);
+        REQUIRE(t.advance(2));
+        REQUIRE(t.ticks_until_fire() == 0);
+      }
+    }
+
+    WHEN("it would advance past firing")
+    {
+      THEN("it refuses, as the firing would be lost")
+      {
+        REQUIRE_THROWS_AS(t.advance(6), std::logic_error);
+        REQUIRE(t.ticks_until_fire() == 5);
+      }
+    }
+  }
+}
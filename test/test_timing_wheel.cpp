@@ -0,0 +1,82 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "../src/util/timing_wheel.hpp"
+
+SCENARIO("TimingWheel wakes ids at their ticks", "[timing_wheel]")
+{
+  using namespace leyval;
+
+  GIVEN("ids due at ticks on every level of the wheel")
+  {
+    const std::vector<std::uint32_t> ticks{ 0,       1,          255,
+                                            256,     300,        65'535,
+                                            70'000,  16'777'216, 16'777'300,
+                                            300,     4'000'000'000 };
+    TimingWheel wheel{ ticks.size() };
+    for (int id{ 0 }; id < static_cast<int>(ticks.size()); ++id) {
+      wheel.schedule(id, ticks[id]);
+    }
+
+    THEN("skipping from one next_tick() to the next wakes each once, in order")
+    {
+      std::map<std::uint32_t, std::vector<int>> woken;
+      while (const auto next{ wheel.next_tick() }) {
+        wheel.advance_to(*next);
+        std::vector<int> due;
+        wheel.pop_due(due);
+        REQUIRE_FALSE(due.empty());
+        std::ranges::sort(due);
+        woken[*next] = due;
+      }
+      REQUIRE(wheel.size() == 0);
+
+      std::map<std::uint32_t, std::vector<int>> expected;
+      for (int id{ 0 }; id < static_cast<int>(ticks.size()); ++id) {
+        expected[ticks[id]].push_back(id);
+      }
+      REQUIRE(woken == expected);
+    }
+
+    THEN("it cannot skip past a due id")
+    {
+      REQUIRE_THROWS_AS(wheel.advance_to(1), std::invalid_argument);
+    }
+  }
+
+  GIVEN("ids rescheduled at random gaps, as a simulation does")
+  {
+    const int num_ids{ 200 };
+    std::mt19937 rng{ 2 };
+    std::geometric_distribution<std::uint32_t> gap{ 0.002 };
+    TimingWheel wheel{ num_ids };
+    std::vector<std::uint32_t> due_at(num_ids);
+    for (int id{ 0 }; id < num_ids; ++id) {
+      due_at[id] = 1 + gap(rng);
+      wheel.schedule(id, due_at[id]);
+    }
+
+    THEN("every id wakes exactly when it is due")
+    {
+      std::vector<int> due;
+      for (int step{ 0 }; step < 5'000; ++step) {
+        const std::uint32_t now{ *wheel.next_tick() };
+        REQUIRE(now == *std::ranges::min_element(due_at));
+        wheel.advance_to(now);
+        due.clear();
+        wheel.pop_due(due);
+        for (const int id : due) {
+          REQUIRE(due_at[id] == now);
+          due_at[id] = now + 1 + gap(rng);
+          wheel.schedule(id, due_at[id]);
+        }
+      }
+      REQUIRE(wheel.size() == num_ids);
+    }
+  }
+}
@@ -0,0 +1,125 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "../src/util/truncated_distribution.hpp"
+
+SCENARIO("inverse_normal_cdf inverts the normal CDF", "[truncated]")
+{
+  for (const double z : { -30.0, -8.0, -1.5, 0.0, 0.3, 2.0 }) {
+    const double p{ 0.5 * std::erfc(-z / std::sqrt(2.0)) };
+    REQUIRE(std::abs(leyval::inverse_normal_cdf(p) - z) < 1e-12);
+  }
+
+  // Upper tail quantiles, from survival probabilities
+  for (const double z : { 7.0, 30.0 }) {
+    const double q{ 0.5 * std::erfc(z / std::sqrt(2.0)) };
+    REQUIRE(std::abs(-leyval::inverse_normal_cdf(q) - z) < 1e-12);
+  }
+}
+
+SCENARIO("TruncatedDistribution samples inside narrow, far out windows",
+         "[truncated]")
+{
+  using namespace leyval;
+  using PRNG = std::mt19937;
+  PRNG rng{ 6 };
+
+  GIVEN("an exponential window holding about e^-30 of the mass")
+  {
+    TruncatedDistribution<std::exponential_distribution<>, PRNG> dist{
+      std::exponential_distribution<>{ 1.0 }
+    };
+    std::vector<double> samples(10'000);
+    dist(rng, samples, 30.0, 31.0);
+
+    THEN("every sample is inside, with the truncated mean")
+    {
+      double sum{ 0 };
+      for (const double x : samples) {
+        REQUIRE(30.0 <= x);
+        REQUIRE(x <= 31.0);
+        sum += x;
+      }
+      // Mean of Exp(1) truncated to [0, 1] is 1 - 1 / (e - 1), stddev ~0.28
+      const double mean{ 30.0 + 1 - 1 / (std::exp(1.0) - 1) };
+      REQUIRE(std::abs(sum / samples.size() - mean) < 5 * 0.28 / 100);
+    }
+  }
+
+  GIVEN("a normal window 8 to 8.5 standard deviations above the mean")
+  {
+    TruncatedDistribution<std::normal_distribution<>, PRNG> dist{
+      std::normal_distribution<>{ 100.0, 2.0 }
+    };
+    std::vector<double> samples(10'000);
+    dist(rng, samples, 116.0, 117.0);
+
+    THEN("every sample is inside, weighted towards the mean")
+    {
+      int num_lower_half{ 0 };
+      for (const double x : samples) {
+        REQUIRE(116.0 <= x);
+        REQUIRE(x <= 117.0);
+        num_lower_half += x < 116.5;
+      }
+      // The density falls by e^-4.1 across the window
+      REQUIRE(num_lower_half > 8'000);
+    }
+  }
+
+  GIVEN("a distribution without a closed form inverse")
+  {
+    TruncatedDistribution<std::gamma_distribution<>, PRNG> dist{
+      std::gamma_distribution<>{ 2.0, 1.0 }
+    };
+    std::vector<double> samples(1'000);
+    dist(rng, samples, 1.0, 2.0);
+
+    THEN("rejection still keeps samples inside")
+    {
+      for (const double x : samples) {
+        REQUIRE(1.0 <= x);
+        REQUIRE(x <= 2.0);
+      }
+    }
+  }
+}
+
+SCENARIO("Batch and scalar sampling agree", "[truncated]")
+{
+  using namespace leyval;
+  using PRNG = std::mt19937;
+  using Dist = TruncatedDistribution<std::exponential_distribution<>, PRNG>;
+  Dist dist{ std::exponential_distribution<>{ 0.5 } };
+
+  PRNG batch_rng{ 9 };
+  std::vector<double> batch(100);
+  dist(batch_rng, batch, 1.0, 4.0);
+
+  PRNG scalar_rng{ 9 };
+  for (const double x : batch) {
+    REQUIRE(dist(scalar_rng, 1.0, 4.0) == x);
+  }
+  REQUIRE_THROWS_AS(dist(scalar_rng, 4.0, 1.0), std::invalid_argument);
+}
+
+SCENARIO("Batch and scalar float sampling agree", "[truncated]")
+{
+  using namespace leyval;
+  using PRNG = std::mt19937;
+  using Dist =
+    TruncatedDistribution<std::exponential_distribution<float>, PRNG>;
+  Dist dist{ std::exponential_distribution<float>{ 0.5F } };
+
+  PRNG batch_rng{ 9 };
+  std::vector<float> batch(100);
+  dist(batch_rng, batch, 1.0F, 4.0F);
+
+  PRNG scalar_rng{ 9 };
+  for (const float x : batch) {
+    REQUIRE(dist(scalar_rng, 1.0F, 4.0F) == x);
+  }
+}